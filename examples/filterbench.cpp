@@ -0,0 +1,80 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QStringList>
+#include <iostream>
+#include <utility>
+
+#include "../include/LiteralMatcher.hpp"
+
+// Compares the regex path filterTable used to take for literal queries against the
+// LiteralMatcher kernels on a million random ASCII cells.
+
+namespace {
+
+QStringList makeCells(int count) {
+    QRandomGenerator random(42);
+    QStringList cells;
+    cells.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QString cell(int(random.bounded(8, 48)), Qt::Uninitialized);
+        for (QChar& c : cell) {
+            c = QChar(char16_t(random.bounded(' ', '~' + 1)));
+        }
+        cells.append(cell);
+    }
+    return cells;
+}
+
+template <typename Fn>
+void run(const char* name, const QStringList& cells, const Fn& matches) {
+    QElapsedTimer timer;
+    timer.start();
+    qsizetype hits = 0;
+    for (const QString& cell : cells) {
+        hits += matches(QStringView(cell)) ? 1 : 0;
+    }
+    std::cout << name << ": " << timer.elapsed() << " ms, " << hits << " hits\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const QString needle = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QStringLiteral("qT6");
+    const QStringList cells = makeCells(1000000);
+
+    QRegularExpression regex(QRegularExpression::escape(needle),
+                             QRegularExpression::CaseInsensitiveOption);
+    regex.optimize();
+    run("QRegularExpression", cells, [&](QStringView cell) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+        return regex.matchView(cell).hasMatch();
+#else
+        return regex.match(cell.toString()).hasMatch();
+#endif
+    });
+
+    if (!LiteralMatcher::canMatch(needle)) {
+        std::cout << "Needle is not plain ASCII; LiteralMatcher does not apply\n";
+        return 0;
+    }
+
+    const std::pair<LiteralMatcher::Kernel, const char*> kernels[] = {
+        {LiteralMatcher::Kernel::Scalar, "LiteralMatcher scalar"},
+        {LiteralMatcher::Kernel::Sse2, "LiteralMatcher SSE2"},
+        {LiteralMatcher::Kernel::Avx2, "LiteralMatcher AVX2"},
+    };
+    for (const auto& [kernel, name] : kernels) {
+        if (!LiteralMatcher::isSupported(kernel)) {
+            std::cout << name << ": not supported on this CPU\n";
+            continue;
+        }
+        LiteralMatcher matcher(needle, Qt::CaseInsensitive, kernel);
+        run(name, cells, [&](QStringView cell) { return matcher.contains(cell); });
+    }
+
+    return 0;
+}
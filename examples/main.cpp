@@ -30,7 +30,10 @@ int main(int argc, char* argv[]) {
     table->logo = QUrl::fromLocalFile("/home/nabiizy/Downloads/logo-white.png");
 
     table->setHorizontalHeaders(QStringList{"ID", "Name", "DOB", "Sex", "CreatedAt", "Time"},
-                                QStringList{"id", "name", "dob", "sex", "created_at", "time"});
+                                QStringList{"id", "name", "dob", "sex", "created_at", "time"},
+                                QList<ColumnType>{ColumnType::Int64, ColumnType::String,
+                                                  ColumnType::Date, ColumnType::String,
+                                                  ColumnType::DateTime, ColumnType::Time});
 
     table->setItemDelegateForColumn(2, new DateDelegate());
     table->setItemDelegateForColumn(3,
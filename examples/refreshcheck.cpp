@@ -0,0 +1,110 @@
+#include <QApplication>
+#include <QEventLoop>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTimer>
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "../include/TableWidget.hpp"
+
+// Checks that a sorted table stays sorted across refreshData(): rows are removed, inserted,
+// edited and reordered by the "backend" while the view is sorted by score, descending.
+// Exits with 1 and says why if the view is out of order or rows went missing.
+
+namespace {
+
+constexpr int idColumn = 0;
+constexpr int scoreColumn = 2;
+
+QStringList makeRow(int id, int score) {
+    return {QString::number(id), QStringLiteral("row %1").arg(id), QString::number(score)};
+}
+
+// Waits for the background sort to be applied.
+bool waitForSort(TableWidget& table) {
+    QEventLoop loop;
+    QObject::connect(&table, &TableWidget::sortFinished, &loop, &QEventLoop::quit);
+    QTimer::singleShot(10000, &loop, [&loop]() { loop.exit(1); });
+    return loop.exec() == 0;
+}
+
+// Empty if the view shows exactly ids, by descending score; otherwise what is wrong.
+QString checkView(const TableWidget& table, const QSet<int>& ids) {
+    const QAbstractItemModel* view = table.model();
+    if (view->rowCount() != ids.size()) {
+        return QStringLiteral("%1 rows shown, %2 expected").arg(view->rowCount()).arg(ids.size());
+    }
+    QSet<int> seen;
+    for (int row = 0; row < view->rowCount(); ++row) {
+        seen.insert(view->index(row, idColumn).data(Qt::EditRole).toInt());
+        if (row > 0 && view->index(row - 1, scoreColumn).data(Qt::EditRole).toLongLong() <
+                           view->index(row, scoreColumn).data(Qt::EditRole).toLongLong()) {
+            return QStringLiteral("rows %1 and %2 are out of order").arg(row - 1).arg(row);
+        }
+    }
+    return seen == ids ? QString() : QStringLiteral("the ids shown differ from the data");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QRandomGenerator random(7);
+
+    TableWidget table;
+    table.setHorizontalHeaders({"ID", "Name", "Score"}, {"id", "name", "score"},
+                               {ColumnType::Int64, ColumnType::String, ColumnType::Int64});
+
+    QVector<QStringList> rows;
+    QSet<int> ids;
+    int nextId = 1;
+    for (; nextId <= 5000; ++nextId) {
+        rows.append(makeRow(nextId, int(random.bounded(1000))));
+        ids.insert(nextId);
+    }
+    table.setData(rows);
+    table.sortTable(scoreColumn, Qt::DescendingOrder);
+    if (!waitForSort(table)) {
+        std::cout << "sort did not finish\n";
+        return 1;
+    }
+
+    for (int poll = 1; poll <= 20; ++poll) {
+        // Drop some rows, rescore some, append a few and hand the rest back in a new order.
+        QVector<QStringList> next;
+        for (const QStringList& row : std::as_const(rows)) {
+            const int id = row[idColumn].toInt();
+            if (random.bounded(20) == 0) {
+                ids.remove(id);
+            } else if (random.bounded(10) == 0) {
+                next.append(makeRow(id, int(random.bounded(1000))));
+            } else {
+                next.append(row);
+            }
+        }
+        for (int i = 0; i < 50; ++i, ++nextId) {
+            const qsizetype at = random.bounded(next.size() + 1);
+            next.insert(at, makeRow(nextId, int(random.bounded(1000))));
+            ids.insert(nextId);
+        }
+        if (poll % 5 == 0) {
+            std::reverse(next.begin(), next.end());
+        }
+        rows = next;
+
+        table.refreshData(rows, idColumn);
+        const QString problem = checkView(table, ids);
+        if (!problem.isEmpty()) {
+            std::cout << "poll " << poll << ": " << problem.toStdString() << '\n';
+            return 1;
+        }
+    }
+
+    std::cout << "sorted view kept its order across 20 refreshes\n";
+    return 0;
+}
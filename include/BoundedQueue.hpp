@@ -0,0 +1,133 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * Fixed-capacity lock-free queue for any number of producers and consumers
+ * (Dmitry Vyukov's bounded MPMC queue). Each slot carries a sequence number that tells
+ * producers and consumers whether it is free or filled, so a push or pop is one CAS on the
+ * shared position plus one release store; no thread ever waits on another.
+ *
+ * Usage:
+ * @code
+ * BoundedQueue<QStringList> queue(4096);
+ * queue.tryPush(QStringList{"1", "Alice"});   // any thread, false when full
+ * QStringList row;
+ * while (queue.tryPop(row)) { ... }           // consumer thread, false when empty
+ * @endcode
+ */
+template <typename T>
+class BoundedQueue {
+   public:
+    /**
+     * Creates a queue holding at least capacity elements.
+     * @param capacity Requested capacity, rounded up to a power of two (minimum 2).
+     */
+    explicit BoundedQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_cells = std::make_unique<Cell[]>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * Appends value unless the queue is full.
+     * @return true if the value was queued, false if the queue is full (value is untouched).
+     */
+    bool tryPush(T&& value) {
+        Cell* cell = nullptr;
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes the oldest value into out unless the queue is empty.
+     * @return true if a value was popped, false if the queue is empty.
+     */
+    bool tryPop(T& out) {
+        Cell* cell = nullptr;
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        out = std::move(cell->value);
+        cell->value = T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Approximate number of queued elements. Exact only when no other thread is
+     * pushing or popping.
+     */
+    [[nodiscard]] std::size_t sizeApprox() const {
+        const std::size_t enqueued = m_enqueuePos.load(std::memory_order_relaxed);
+        const std::size_t dequeued = m_dequeuePos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    [[nodiscard]] std::size_t capacity() const { return m_mask + 1; }
+
+   private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    std::size_t m_mask{};
+
+    // Producers and consumers hammer different positions, keep them on separate cache lines.
+    alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+    alignas(64) std::atomic<std::size_t> m_dequeuePos{0};
+};
+
+#endif  // BOUNDED_QUEUE_H
@@ -0,0 +1,537 @@
+#ifndef COLUMNAR_TABLE_MODEL_H
+#define COLUMNAR_TABLE_MODEL_H
+
+#include <QAbstractTableModel>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVector>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include "qt6plus_export.hpp"
+
+class QSqlDatabase;
+class QSqlQuery;
+
+/**
+ * Array of a trivially copyable T kept in a QByteArray. Like QString it can wrap memory it
+ * does not own (fromRawData()), such as a mapped file, and copies it on first modification.
+ */
+template <typename T>
+class PodArray {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+   public:
+    PodArray() = default;
+
+    // An array of size elements with unspecified values.
+    explicit PodArray(qsizetype size) : m_bytes(size * qsizetype(sizeof(T)), Qt::Uninitialized) {}
+
+    // An array over size elements at data, which must outlive it (and its copies) unmodified.
+    static PodArray fromRawData(const T* data, qsizetype size) {
+        PodArray array;
+        const qsizetype bytes = size * qsizetype(sizeof(T));
+        array.m_bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), bytes);
+        return array;
+    }
+
+    [[nodiscard]] qsizetype size() const { return m_bytes.size() / qsizetype(sizeof(T)); }
+    [[nodiscard]] const T* constData() const {
+        return reinterpret_cast<const T*>(m_bytes.constData());
+    }
+    [[nodiscard]] T* data() { return reinterpret_cast<T*>(m_bytes.data()); }
+    [[nodiscard]] const T* begin() const { return constData(); }
+    [[nodiscard]] const T* end() const { return constData() + size(); }
+    [[nodiscard]] const T& operator[](qsizetype i) const { return constData()[i]; }
+    [[nodiscard]] T& operator[](qsizetype i) { return data()[i]; }
+
+    void reserve(qsizetype size) { m_bytes.reserve(size * qsizetype(sizeof(T))); }
+    void append(T value) { m_bytes.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    void append(const PodArray& other) { m_bytes.append(other.m_bytes); }
+    void insert(qsizetype i, qsizetype count, T value) {
+        m_bytes.insert(i * qsizetype(sizeof(T)), count * qsizetype(sizeof(T)), '\0');
+        std::fill_n(data() + i, count, value);
+    }
+    void remove(qsizetype i, qsizetype count) {
+        m_bytes.remove(i * qsizetype(sizeof(T)), count * qsizetype(sizeof(T)));
+    }
+    void clear() { m_bytes.clear(); }
+
+   private:
+    QByteArray m_bytes;
+};
+
+// How a column stores its cells (see ColumnarTableModel::setColumnTypes()).
+enum class ColumnType {
+    String,    // Text
+    Int64,     // Whole numbers
+    Double,    // Floating-point numbers
+    Bool,      // true/false; also read from 1/0, yes/no, on/off (any case)
+    Date,      // Calendar dates, as ISO 8601 text (yyyy-MM-dd)
+    DateTime,  // Instants, kept in UTC; text without an offset is taken as UTC
+    Time,      // Times of day, to the millisecond
+};
+
+/**
+ * A single table column stored as one contiguous UTF-16 buffer plus per-row offsets.
+ * A cell costs its string payload plus 12 bytes of bookkeeping, instead of a heap-allocated
+ * QStandardItem holding its own QString. Copies are cheap because all members are implicitly
+ * shared, which also makes a copy a consistent snapshot that other threads can read.
+ * A column can also be laid over memory it doesn't own, like a mapped snapshot file (see
+ * fromRawData()); it is then copied on its first modification.
+ *
+ * A typed column (any ColumnType but String) keeps one 8-byte native value per cell instead:
+ * text given to it is parsed once on the way in, and formatted only when asked for.
+ *
+ * A String column whose few distinct values repeat over many rows (a status, a department)
+ * can be dictionary-encoded (see encodeIfRepetitive()): each distinct text is then stored
+ * once, as a dictionary entry, and a cell costs a 4-byte code. Filters and sorts evaluate
+ * each entry once and compare codes per row.
+ */
+class QT6PLUS_EXPORT TableColumn {
+   public:
+    // Value of null cells in typed columns other than Double, whose null is NaN.
+    static constexpr qint64 nullValue = std::numeric_limits<qint64>::min();
+
+    TableColumn() = default;
+
+    // An empty column storing its cells as type.
+    explicit TableColumn(ColumnType type) : m_type(type) {}
+
+    [[nodiscard]] ColumnType type() const { return m_type; }
+    [[nodiscard]] bool isTyped() const { return m_type != ColumnType::String; }
+
+    // Number of rows (cells) in the column.
+    [[nodiscard]] int size() const {
+        if (isTyped()) {
+            return static_cast<int>(m_values.size());
+        }
+        return static_cast<int>(m_encoded ? m_codes.size() : m_lengths.size());
+    }
+
+    // Returns a view of the cell text of a String column (see text(int, QString&) for any
+    // column). Valid until the column is next modified.
+    [[nodiscard]] QStringView text(int row) const {
+        Q_ASSERT(!isTyped());
+        return entry(m_encoded ? qsizetype(m_codes[row]) : row);
+    }
+
+    // Returns the text of a cell: a view of a String cell, or a typed one formatted into
+    // buffer. Valid until the column is next modified or buffer is next changed.
+    [[nodiscard]] QStringView text(int row, QString& buffer) const;
+
+    // True if the cell is empty, or holds no value in a typed column.
+    [[nodiscard]] bool isNull(int row) const;
+
+    /**
+     * Native value of a cell of a typed column other than Double: the number for Int64,
+     * 0 or 1 for Bool, the Julian day for Date, milliseconds since the epoch for DateTime and
+     * since midnight for Time. nullValue, which orders first, if the cell is null.
+     */
+    [[nodiscard]] qint64 integer(int row) const { return m_values[row]; }
+
+    // Value of a cell of a typed column as a number, e.g. a sort key; NaN if null.
+    [[nodiscard]] double number(int row) const;
+
+    // Value of a cell as its type's QVariant (QString, qlonglong, double, bool, QDate,
+    // QDateTime or QTime); an invalid QVariant if a typed cell is null.
+    [[nodiscard]] QVariant value(int row) const;
+
+    // Replaces a cell with value converted to the column's type; strings are parsed as text.
+    void setValue(int row, const QVariant& value);
+
+    // A copy of the column storing its cells as type, each cell converted through its text
+    // once. Cells whose text doesn't parse as type become null.
+    [[nodiscard]] TableColumn converted(ColumnType type) const;
+
+    // True if the column is dictionary-encoded.
+    [[nodiscard]] bool isEncoded() const { return m_encoded; }
+
+    // Dictionary code of a cell of an encoded column: the index of its text's entry.
+    [[nodiscard]] quint32 code(int row) const { return m_codes[row]; }
+
+    // Number of entries of an encoded column's dictionary. Entries no cell uses any more
+    // may remain after edits.
+    [[nodiscard]] int dictionarySize() const { return static_cast<int>(m_lengths.size()); }
+
+    // Text of the dictionary entry with code.
+    [[nodiscard]] QStringView entry(qsizetype code) const {
+        return {m_chars.constData() + m_starts[code], m_lengths[code]};
+    }
+
+    /**
+     * Dictionary-encodes a String column if its cells repeat enough: at most one distinct
+     * text per maxRatio cells, over at least 64 cells. Distinct values are counted with an
+     * early exit, so a column that doesn't qualify costs little more than the scan of the
+     * cells read until then. An encoded column that collects too many distinct values
+     * through later appends and edits goes back to plain storage by itself.
+     * @return true if the column is encoded afterwards.
+     */
+    bool encodeIfRepetitive(int maxRatio = 8);
+
+    // Reserves room for rows cells holding chars UTF-16 code units in total.
+    void reserve(int rows, qsizetype chars);
+
+    // Appends a cell to the end of the column, parsed if the column is typed; text that
+    // doesn't parse as the column's type is stored as null.
+    void append(QStringView text);
+
+    // Appends a cell given as UTF-8, decoding it straight into the column's buffer.
+    void appendUtf8(QByteArrayView utf8);
+
+    // Replaces the text of an existing cell, parsed as for append().
+    void set(int row, QStringView text);
+
+    // Like set(), unless the cell already holds text (or, typed, the value text parses to).
+    // Returns whether the cell changed.
+    bool update(int row, QStringView text);
+
+    // Inserts count empty (null) cells before row.
+    void insert(int row, int count);
+
+    // Removes count cells starting at row.
+    void remove(int row, int count);
+
+    // Grows (with empty cells) or shrinks the column to rows cells.
+    void resize(int rows);
+
+    // Reorders the cells so that cell i becomes the old cell order[i]. Text is not moved.
+    void permute(const QList<int>& order);
+
+    void clear();
+
+    // Joins parts, all of one type, end to end into one column, allocating its buffers once.
+    [[nodiscard]] static TableColumn concat(const QList<TableColumn>& parts);
+
+    // Rewrites the buffer without the text of replaced or removed cells.
+    void squeeze();
+
+    // Raw storage, for serialisation: the text buffer and each cell's offset and length in
+    // it, or each dictionary entry's if encoded. The buffer may hold text no cell refers to
+    // any more, unless squeezed.
+    [[nodiscard]] QStringView chars() const { return m_chars; }
+    [[nodiscard]] const qsizetype* starts() const { return m_starts.constData(); }
+    [[nodiscard]] const int* lengths() const { return m_lengths.constData(); }
+
+    // Raw storage of an encoded column: one code per cell.
+    [[nodiscard]] const quint32* codes() const { return m_codes.constData(); }
+
+    // Raw storage of a typed column: one value per cell, Double ones as their bits.
+    [[nodiscard]] const qint64* values() const { return m_values.constData(); }
+
+    /**
+     * A column of rows cells over storage laid out as chars(), starts() and lengths()
+     * describe, which is used in place rather than copied.
+     * @param owner Keeps the memory alive as long as the column or any copy refers to it.
+     */
+    [[nodiscard]] static TableColumn fromRawData(QStringView chars, const qsizetype* starts,
+                                                 const int* lengths, int rows,
+                                                 std::shared_ptr<const void> owner);
+
+    // An encoded column of rows cells over codes and a dictionary of entries entries, laid
+    // out as codes(), chars(), starts() and lengths() describe.
+    [[nodiscard]] static TableColumn fromRawData(QStringView chars, const qsizetype* starts,
+                                                 const int* lengths, int entries,
+                                                 const quint32* codes, int rows,
+                                                 std::shared_ptr<const void> owner);
+
+    // A typed column of rows cells over values laid out as values() describes.
+    [[nodiscard]] static TableColumn fromRawData(ColumnType type, const qint64* values, int rows,
+                                                 std::shared_ptr<const void> owner);
+
+   private:
+    // Squeezes the buffer once garbage outweighs the live data.
+    void compactIfWasteful();
+
+    // Code of text in an encoded column, adding a dictionary entry for new text.
+    quint32 codeFor(QStringView text);
+
+    // Rebuilds m_slots for the current dictionary.
+    void rehash(qsizetype slots);
+
+    // Switches an encoded column back to plain storage.
+    void decode();
+
+    ColumnType m_type = ColumnType::String;
+    QString m_chars;                      // Cell payloads (or dictionary entries), back to back
+    PodArray<qsizetype> m_starts;         // Offset of each cell (or entry) in m_chars
+    PodArray<int> m_lengths;              // Length of each cell (or entry) in UTF-16 code units
+    qsizetype m_garbage{};                // Code units in m_chars no longer referenced by any cell
+    PodArray<qint64> m_values;            // Native value of each cell of a typed column
+    bool m_encoded = false;               // Dictionary-encoded
+    PodArray<quint32> m_codes;            // Dictionary code of each cell, if encoded
+    PodArray<quint32> m_slots;            // Open-addressing hash of entries: code + 1, 0 if free
+    std::shared_ptr<const void> m_owner;  // Memory the buffers are laid over, if not their own
+};
+
+/**
+ * Table model that keeps its cells column by column in TableColumn stores.
+ * It is a drop-in replacement for the parts of QStandardItemModel used by TableWidget
+ * (header labels, row/column counts, clear) without allocating an item per cell.
+ * String columns whose values repeat are dictionary-encoded as rows are loaded (see
+ * TableColumn::encodeIfRepetitive()).
+ */
+class QT6PLUS_EXPORT ColumnarTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+   public:
+    explicit ColumnarTableModel(QObject* parent = nullptr);
+    ~ColumnarTableModel() override;
+
+    [[nodiscard]] int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    [[nodiscard]] int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+
+    [[nodiscard]] QVariant data(const QModelIndex& index,
+                                int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value,
+                 int role = Qt::EditRole) override;
+
+    [[nodiscard]] QVariant headerData(int section, Qt::Orientation orientation,
+                                      int role = Qt::DisplayRole) const override;
+    bool setHeaderData(int section, Qt::Orientation orientation, const QVariant& value,
+                       int role = Qt::EditRole) override;
+
+    [[nodiscard]] Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+    [[nodiscard]] bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    bool insertRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
+    bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
+    bool insertColumns(int column, int count, const QModelIndex& parent = QModelIndex()) override;
+    bool removeColumns(int column, int count, const QModelIndex& parent = QModelIndex()) override;
+
+    // Grows or shrinks the table, like QStandardItemModel::setRowCount.
+    void setRowCount(int rows);
+
+    // Grows or shrinks the table, like QStandardItemModel::setColumnCount.
+    void setColumnCount(int columns);
+
+    // Sets the horizontal header labels, adding columns if there are more labels than columns.
+    void setHorizontalHeaderLabels(const QStringList& labels);
+
+    // Sets the vertical header labels, adding rows if there are more labels than rows.
+    void setVerticalHeaderLabels(const QStringList& labels);
+
+    // Removes all cells and header labels.
+    void clear();
+
+    // Returns a view of the cell text of a String column. Valid until the model is next
+    // modified.
+    [[nodiscard]] QStringView cell(int row, int column) const;
+
+    // Returns the cell text, typed cells formatted as for Qt::DisplayRole.
+    [[nodiscard]] QString text(int row, int column) const;
+
+    // Replaces the text of a cell and notifies views, bypassing flags().
+    void setText(int row, int column, QStringView text);
+
+    /**
+     * Sets how each column stores its cells; columns without an entry hold strings. Typed
+     * columns keep native values, so sorting and exports read them without parsing, and
+     * are formatted only for Qt::DisplayRole (Qt::EditRole gives the native QVariant).
+     * Existing cells are converted in a single model reset, text that doesn't parse
+     * becoming null, and later loads are parsed on the way in.
+     */
+    void setColumnTypes(const QList<ColumnType>& types);
+
+    [[nodiscard]] ColumnType columnType(int column) const {
+        return m_columnTypes.value(column, ColumnType::String);
+    }
+
+    // Cells loaded through resetRows() or appendRows() whose text equals one of these
+    // tokens are stored empty.
+    void setNullTokens(const QStringList& tokens);
+    [[nodiscard]] const QStringList& nullTokens() const { return m_nullTokens; }
+
+    // Replaces all rows in a single model reset. Header labels are kept.
+    // Rows are truncated or padded with empty cells to columns.
+    void resetRows(const QVector<QStringList>& rows, int columns);
+
+    /**
+     * Replaces all rows with rows, changing only what differs. Rows are matched to the
+     * current ones by the cell in keyColumn (compared as stored, so "007" matches 7 in an
+     * Int64 column); the first row with a key claims it, later ones count as new. Rows
+     * whose key is gone are removed, new keys are inserted where rows puts them, and the
+     * cells of matched rows are compared and only the changed ones rewritten. Views get
+     * rowsRemoved/rowsInserted per contiguous range and dataChanged per run of changed
+     * rows (plus one layout change if matched rows changed order), so persistent indexes,
+     * selection and scroll position survive. Apart from hashing the keys, the cost follows
+     * the number of changes. Rows are truncated or padded to the current column count.
+     * @return false, changing nothing, if keyColumn isn't a column.
+     */
+    bool refreshRows(const QVector<QStringList>& rows, int keyColumn);
+
+    /**
+     * Replaces all rows with prebuilt column stores in a single model reset, e.g. from
+     * CsvImporter, without copying cells. Header labels are kept. Columns are truncated or
+     * padded with empty cells to the length of the first, and converted to the column
+     * types set, if they differ.
+     */
+    void resetColumns(QList<TableColumn> columns);
+
+    // Appends rows in a single rowsInserted notification.
+    // Rows are truncated or padded with empty cells to the current column count.
+    void appendRows(const QVector<QStringList>& rows);
+
+    /**
+     * Reorders every row in one layout change, e.g. to apply RowSorter::sortedRows().
+     * Persistent indexes follow their rows, and rowsPermuted() is emitted before
+     * layoutChanged() so proxies can remap per-row state first.
+     * @param order The old row to place at each position; a permutation of all rows.
+     */
+    void permuteRows(const QList<int>& order);
+
+    /**
+     * Starts a batch of mutations. Until the matching endBatch(), no per-change signals are
+     * emitted; views see the whole batch as one model reset. Batches nest.
+     */
+    void beginBatch();
+
+    // Ends a batch started with beginBatch(). The outermost call notifies views.
+    void endBatch();
+
+    // True between beginBatch() and the outermost endBatch().
+    [[nodiscard]] bool inBatch() const { return m_batchDepth > 0; }
+
+    /**
+     * Replaces the table contents with the result of a SQL query that is read lazily.
+     * The query runs forward-only; only the first page is read now, further pages are read
+     * by fetchMore() as views scroll towards the end. Column labels come from the result's
+     * field names. Any later resetRows() or clear() releases the query.
+     * @param database Open database to run the query on. Must outlive the binding.
+     * @param sql Statement to execute.
+     * @param pageSize Rows read per fetchMore() call.
+     * @param windowRows Maximum rows kept in memory; once exceeded the oldest rows are
+     * dropped. 0 keeps every row read.
+     * @return true if the query executed, false otherwise (see queryError()).
+     */
+    bool bindQuery(const QSqlDatabase& database, const QString& sql, int pageSize = 1000,
+                   int windowRows = 0);
+
+    // True while a query bound with bindQuery() still has unread rows.
+    [[nodiscard]] bool hasPendingQuery() const;
+
+    // Error from the last bindQuery() or page read, empty if none.
+    [[nodiscard]] const QString& queryError() const { return m_queryError; }
+
+    // Number of leading query rows dropped to respect the bindQuery() window.
+    [[nodiscard]] qint64 droppedRows() const { return m_droppedRows; }
+
+    /**
+     * Writes every cell, the column types, header labels and metadata to path in a columnar
+     * binary layout that loadSnapshot() maps rather than parses. The file is replaced
+     * atomically, so a snapshot that is currently loaded from the same path stays intact.
+     * @return false if the file can't be written (see snapshotError()).
+     */
+    bool saveSnapshot(const QString& path, const QVariantMap& metadata = {}) const;
+
+    /**
+     * Replaces the table and its column types with a file written by saveSnapshot(), in a
+     * single model reset. The file is memory-mapped and the column stores are laid over it,
+     * so loading takes milliseconds whatever the row count: cells are read from the mapping,
+     * and a column is only copied into memory when it is edited. Only the layout is
+     * validated, not every cell offset or code, so load only files written by saveSnapshot()
+     * on the same kind of platform.
+     * @param metadata Receives the metadata saved with the snapshot.
+     * @return false if the file can't be mapped or isn't a snapshot (see snapshotError()).
+     */
+    bool loadSnapshot(const QString& path, QVariantMap* metadata = nullptr);
+
+    // Error from the last saveSnapshot() or loadSnapshot(), empty if none.
+    [[nodiscard]] const QString& snapshotError() const { return m_snapshotError; }
+
+    // Direct read access to a column store.
+    [[nodiscard]] const TableColumn& column(int column) const { return m_columns[column]; }
+
+    // All column stores. Copying the list is cheap and gives a snapshot that background
+    // threads can read while the model keeps changing.
+    [[nodiscard]] const QList<TableColumn>& columns() const { return m_columns; }
+
+   signals:
+    // Emitted by permuteRows() between layoutAboutToBeChanged() and layoutChanged().
+    void rowsPermuted(const QList<int>& order);
+
+   private:
+    // Text stored for cell column of a row being loaded: empty if missing or a null token.
+    [[nodiscard]] QStringView loadedText(const QStringList& cells, int column) const;
+
+    // Appends one row of cells to every column, applying null tokens.
+    void appendRowCells(const QStringList& cells);
+
+    // Inserts count rows of cells, rows[from] onwards, at row.
+    void insertRowCells(int row, const QVector<QStringList>& rows, int from, int count);
+
+    // Dictionary-encodes the String columns whose values repeat enough, in parallel.
+    void encodeRepetitiveColumns();
+
+    // Releases a query bound with bindQuery().
+    void releaseQuery();
+
+    QList<TableColumn> m_columns;
+    QList<ColumnType> m_columnTypes;
+    QStringList m_horizontalLabels;
+    QStringList m_verticalLabels;
+    QStringList m_nullTokens;
+    int m_rowCount{};
+    int m_batchDepth{};
+
+    // Lazily read query (see bindQuery)
+    std::unique_ptr<QSqlQuery> m_query;
+    QString m_queryError;
+    int m_pageSize{};
+    int m_windowRows{};
+    qint64 m_droppedRows{};
+
+    mutable QString m_snapshotError;
+};
+
+/**
+ * A row of a ColumnarTableModel by reference: a model pointer and a source row, so making
+ * one allocates nothing. Cells are read from the column stores only when asked for, String
+ * cells as views of the stored text. Like those views it is valid until the model is next
+ * modified, so don't keep it (or queue it across threads); copy what is needed with
+ * toStringList() or text().
+ */
+class QT6PLUS_EXPORT RowRef {
+   public:
+    RowRef() = default;
+    RowRef(const ColumnarTableModel* model, int row) : m_model(model), m_row(row) {}
+
+    // False for a default-constructed RowRef, e.g. when there is no current row.
+    [[nodiscard]] bool isValid() const { return m_model != nullptr && m_row >= 0; }
+
+    // Row in the model (not the view, which may be sorted or filtered).
+    [[nodiscard]] int row() const { return m_row; }
+
+    [[nodiscard]] int columnCount() const { return m_model->columnCount(); }
+
+    // Text of the cell in column: a view of a String cell, or a typed one formatted into
+    // buffer (see TableColumn::text()).
+    [[nodiscard]] QStringView cell(int column, QString& buffer) const {
+        return m_model->column(column).text(m_row, buffer);
+    }
+
+    // A copy of the cell text, typed cells formatted as for Qt::DisplayRole.
+    [[nodiscard]] QString text(int column) const { return m_model->text(m_row, column); }
+
+    // Native value of the cell (see TableColumn::value()).
+    [[nodiscard]] QVariant value(int column) const { return m_model->column(column).value(m_row); }
+
+    // Copies every cell's text, as the QStringList row signals carry.
+    [[nodiscard]] QStringList toStringList() const;
+
+   private:
+    const ColumnarTableModel* m_model = nullptr;
+    int m_row = -1;
+};
+
+#endif  // COLUMNAR_TABLE_MODEL_H
@@ -0,0 +1,53 @@
+#ifndef LITERAL_MATCHER_H
+#define LITERAL_MATCHER_H
+
+#include <QString>
+#include <QStringView>
+
+#include "qt6plus_export.hpp"
+
+/**
+ * Substring search for a plain (non-regex) ASCII needle in UTF-16 text, optionally ignoring
+ * ASCII case. Candidate positions are found 8 (SSE2) or 16 (AVX2) code units at a time by
+ * comparing the needle's first and last characters, then verified. The best kernel is
+ * picked at runtime; a scalar kernel covers other CPUs.
+ *
+ * Case-insensitive searches that fail on text containing non-ASCII characters are retried
+ * with QStringView::contains(), so Unicode case folding (e.g. KELVIN SIGN vs 'k') gives the
+ * same answer as the regex engine.
+ */
+class QT6PLUS_EXPORT LiteralMatcher {
+   public:
+    enum class Kernel {
+        Best,    // Fastest kernel the CPU supports
+        Scalar,  // Portable fallback
+        Sse2,
+        Avx2,
+    };
+
+    /**
+     * @param needle Text to find. Must satisfy canMatch().
+     * @param cs Whether to ignore ASCII case.
+     * @param kernel Kernel to use; unsupported choices fall back to Best. Mostly for benchmarks.
+     */
+    LiteralMatcher(QStringView needle, Qt::CaseSensitivity cs, Kernel kernel = Kernel::Best);
+
+    // True if needle can be searched with this class (non-empty, ASCII only).
+    [[nodiscard]] static bool canMatch(QStringView needle);
+
+    // True if the CPU supports kernel.
+    [[nodiscard]] static bool isSupported(Kernel kernel);
+
+    // Kernel actually used.
+    [[nodiscard]] Kernel kernel() const { return m_kernel; }
+
+    // True if haystack contains the needle.
+    [[nodiscard]] bool contains(QStringView haystack) const;
+
+   private:
+    QString m_needle;  // Lower-cased when ignoring case
+    Qt::CaseSensitivity m_cs;
+    Kernel m_kernel;
+};
+
+#endif  // LITERAL_MATCHER_H
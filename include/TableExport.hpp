@@ -0,0 +1,193 @@
+#ifndef TABLE_EXPORT_H
+#define TABLE_EXPORT_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <atomic>
+#include <functional>
+
+#include "ColumnarTableModel.hpp"
+#include "qt6plus_export.hpp"
+
+/**
+ * What a table shows, captured on the GUI thread so it can be exported from another thread
+ * while the table keeps changing: the column stores (cheap, implicitly shared copies), the
+ * source rows in display order and a name per column.
+ */
+struct QT6PLUS_EXPORT TableSnapshot {
+    QList<TableColumn> columns;
+    QList<int> rows;    // Source row shown at each position
+    QStringList names;  // Column names, used for header rows and keys
+
+    // Every row of model in model order, named by its horizontal header labels.
+    static TableSnapshot of(const ColumnarTableModel& model);
+
+    [[nodiscard]] int rowCount() const { return static_cast<int>(rows.size()); }
+    [[nodiscard]] int columnCount() const { return static_cast<int>(columns.size()); }
+
+    // Text of the cell at position index (not source row) in column; typed cells are
+    // formatted into buffer (see TableColumn::text()).
+    [[nodiscard]] QStringView cell(int index, int column, QString& buffer) const {
+        return columns[column].text(rows[index], buffer);
+    }
+};
+
+/**
+ * Turns a TableSnapshot into text for TableExporter, one piece at a time, so a whole export
+ * never has to be held in memory. New export formats subclass this.
+ *
+ * TableExporter calls writeRow() from several threads at once for different rows, so it
+ * must only read state set up in prepare().
+ */
+class QT6PLUS_EXPORT ExportFormatter {
+   public:
+    virtual ~ExportFormatter() = default;
+
+    // Called once before anything is written, to precompute per-column state.
+    virtual void prepare(const TableSnapshot& snapshot);
+
+    // Appends what precedes the first row.
+    virtual void writeHeader(const TableSnapshot& snapshot, QString& out) const;
+
+    // Appends the row at position index of snapshot. Called concurrently.
+    virtual void writeRow(const TableSnapshot& snapshot, int index, QString& out) const = 0;
+
+    // Appends what follows the last row.
+    virtual void writeFooter(const TableSnapshot& snapshot, QString& out) const;
+};
+
+/**
+ * RFC 4180 CSV. Fields containing a comma, double quote, CR or LF are enclosed in double
+ * quotes, with embedded quotes doubled.
+ */
+class QT6PLUS_EXPORT CsvFormatter : public ExportFormatter {
+   public:
+    /**
+     * @param headerRow Whether to start with a row of column names.
+     * @param lineEnd Record terminator. RFC 4180 specifies CRLF.
+     */
+    explicit CsvFormatter(bool headerRow = true, QString lineEnd = QStringLiteral("\r\n"));
+
+    void writeHeader(const TableSnapshot& snapshot, QString& out) const override;
+    void writeRow(const TableSnapshot& snapshot, int index, QString& out) const override;
+
+    // Appends text as one field, quoted if it needs to be or if alwaysQuote is set.
+    static void appendField(QString& out, QStringView text, bool alwaysQuote = false);
+
+   private:
+    bool m_headerRow;
+    QString m_lineEnd;
+};
+
+// How a JSON export lays out its rows.
+enum class JsonLayout {
+    Array,  // One array of row objects
+    Lines,  // NDJSON: one row object per line
+};
+
+// How a column's cells are written as JSON values.
+enum class JsonValueType {
+    String,   // The text, as a string
+    Integer,  // A whole number; null if the text isn't one
+    Double,   // A number; null if the text isn't a finite one
+    Bool,     // true/false from true/false, 1/0, yes/no, on/off (any case); otherwise null
+};
+
+struct JsonExportOptions {
+    JsonLayout layout = JsonLayout::Array;
+
+    // Value type per column. Columns without an entry follow their storage: Int64, Double
+    // and Bool columns are written as such (from their values, without parsing text), the
+    // rest as strings.
+    QList<JsonValueType> columnTypes;
+
+    // Write empty String cells (including null tokens stored empty) as null.
+    bool emptyAsNull = false;
+};
+
+/**
+ * Streaming JSON writer: rows become objects keyed by column name. Keys are escaped once per
+ * column in prepare(), and values are appended straight to the output without building
+ * QJsonObjects.
+ */
+class QT6PLUS_EXPORT JsonFormatter : public ExportFormatter {
+   public:
+    explicit JsonFormatter(JsonExportOptions options = {});
+
+    void prepare(const TableSnapshot& snapshot) override;
+    void writeHeader(const TableSnapshot& snapshot, QString& out) const override;
+    void writeRow(const TableSnapshot& snapshot, int index, QString& out) const override;
+    void writeFooter(const TableSnapshot& snapshot, QString& out) const override;
+
+    // Appends text as a quoted, escaped JSON string.
+    static void appendString(QString& out, QStringView text);
+
+   private:
+    // Appends one cell converted to type.
+    void appendValue(QString& out, QStringView text, JsonValueType type) const;
+
+    JsonExportOptions m_options;
+    QStringList m_keys;  // Per column: separator, escaped key and colon, e.g. ,"name":
+    QList<JsonValueType> m_types;
+};
+
+// The HTML table shown by TableWidget's print preview. Text is HTML-escaped.
+class QT6PLUS_EXPORT HtmlFormatter : public ExportFormatter {
+   public:
+    void writeHeader(const TableSnapshot& snapshot, QString& out) const override;
+    void writeRow(const TableSnapshot& snapshot, int index, QString& out) const override;
+    void writeFooter(const TableSnapshot& snapshot, QString& out) const override;
+
+    // Appends text with <, >, & and " escaped.
+    static void appendEscaped(QString& out, QStringView text);
+};
+
+/**
+ * Runs a formatter over a snapshot in parallel. Rows are split into chunks that are
+ * formatted (and UTF-8 encoded) concurrently on the global thread pool, a window of a few
+ * chunks per thread at a time, then written in row order. The window's buffers are reused,
+ * so memory stays flat however many rows are exported.
+ */
+class QT6PLUS_EXPORT TableExporter {
+   public:
+    // Receives the number of rows written so far.
+    using Progress = std::function<void(qint64 rowsWritten)>;
+
+    // Rows formatted per chunk (default 2048).
+    void setChunkRows(int rows);
+
+    /**
+     * Writes snapshot to device on the calling thread.
+     * @param device Open for writing. Files and buffers may be written from a worker thread
+     * as long as nothing else uses them meanwhile.
+     * @param cancelled Polled between chunks; when raised the export stops.
+     * @param progress Called after each chunk is written.
+     * @return false if cancelled or a write failed (see errorString()).
+     */
+    bool write(const TableSnapshot& snapshot, ExportFormatter& formatter,
+               QIODevice* device, const std::atomic<bool>* cancelled = nullptr,
+               const Progress& progress = {});
+
+    // Formats snapshot into a string, for callers that need the whole text.
+    [[nodiscard]] QString format(const TableSnapshot& snapshot, ExportFormatter& formatter);
+
+    // Why the last write() failed, empty if it succeeded.
+    [[nodiscard]] const QString& errorString() const { return m_error; }
+
+   private:
+    // Formats the header, row chunks and footer and hands each piece to sink in order,
+    // encoded to UTF-8 as well when encode is set. Stops when sink returns false.
+    bool run(const TableSnapshot& snapshot, ExportFormatter& formatter, bool encode,
+             const std::atomic<bool>* cancelled,
+             const std::function<bool(const QString& text, const QByteArray& bytes)>& sink,
+             const Progress& progress = {});
+
+    int m_chunkRows = 2048;
+    QString m_error;
+};
+
+#endif  // TABLE_EXPORT_H
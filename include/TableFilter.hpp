@@ -0,0 +1,414 @@
+#ifndef TABLE_FILTER_H
+#define TABLE_FILTER_H
+
+#include <QAbstractProxyModel>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMetaObject>
+#include <QRegularExpression>
+#include <QSortFilterProxyModel>
+#include <QStringView>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "ColumnarTableModel.hpp"
+#include "LiteralMatcher.hpp"
+#include "TableSort.hpp"
+#include "TrigramIndex.hpp"
+#include "qt6plus_export.hpp"
+
+namespace parallel {
+class TaskGroup;
+}
+
+/**
+ * One bit per source row. Rows are packed 64 to a word so disjoint 64-aligned ranges can be
+ * written from different threads, provided the bitmap is not shared (call detach() first).
+ */
+class QT6PLUS_EXPORT RowBitmap {
+   public:
+    RowBitmap() = default;
+    explicit RowBitmap(int size) { resize(size); }
+
+    [[nodiscard]] int size() const { return m_size; }
+
+    [[nodiscard]] bool test(int row) const {
+        return (m_words[row >> 6] >> (row & 63)) & 1U;
+    }
+
+    // The 64 bits holding row, so callers can skip empty runs quickly.
+    [[nodiscard]] quint64 wordAt(int row) const { return m_words[row >> 6]; }
+
+    void set(int row, bool value = true) {
+        const quint64 bit = quint64(1) << (row & 63);
+        if (value) {
+            m_words[row >> 6] |= bit;
+        } else {
+            m_words[row >> 6] &= ~bit;
+        }
+    }
+
+    // Grows with cleared bits or shrinks to size bits.
+    void resize(int size);
+
+    // Inserts count cleared bits before row.
+    void insert(int row, int count);
+
+    // Removes count bits starting at row.
+    void remove(int row, int count);
+
+    // Number of set bits.
+    [[nodiscard]] int count() const;
+
+    // Reorders the bits so that bit i becomes the old bit order[i].
+    void permute(const QList<int>& order);
+
+    // Gives this bitmap its own copy of the bits before concurrent writes.
+    void detach() { m_words.detach(); }
+
+   private:
+    QList<quint64> m_words;
+    int m_size{};
+};
+
+/**
+ * A filter query: a row matches when any of its filter columns matches the expression.
+ * Plain ASCII literals are searched with LiteralMatcher instead of the regex engine.
+ * Immutable once built, so one instance can be shared by every worker thread.
+ *
+ * Rows are read from a list of column stores: a model's columns() on the GUI thread, or a
+ * snapshot of them on any other.
+ */
+class QT6PLUS_EXPORT RowMatcher {
+   public:
+    /**
+     * @param regex Expression cells are matched against.
+     * @param column Column to match, or -1 for every column.
+     */
+    RowMatcher(const QRegularExpression& regex, int column);
+
+    [[nodiscard]] const QRegularExpression& regex() const { return m_regex; }
+    [[nodiscard]] int column() const { return m_column; }
+
+    // True if the pattern has no regex syntax and so matches as a plain substring.
+    [[nodiscard]] bool isLiteral() const { return !m_literal.isNull(); }
+
+    /**
+     * True if every row this matcher accepts is also accepted by previous: both are literal
+     * on the same column and options, and this literal contains the previous one
+     * (typing "abc" after "ab"). Only rows previous accepted then need scanning.
+     */
+    [[nodiscard]] bool narrows(const RowMatcher& previous) const;
+
+    /**
+     * Literal runs every match must contain, e.g. {"inv", "2024"} for "inv.*2024".
+     * Empty when none can be derived (alternation, inline options, ...).
+     */
+    [[nodiscard]] const QStringList& requiredLiterals() const { return m_requiredLiterals; }
+
+    // True if text matches the expression.
+    [[nodiscard]] bool matches(QStringView text) const;
+
+    // True if any filter column of row matches.
+    [[nodiscard]] bool matchesRow(const QList<TableColumn>& columns, int row) const;
+
+    /**
+     * Evaluates rows [first, first + count) in parallel on the global thread pool, storing
+     * the result in the same bits of bitmap, which must already cover those rows.
+     * @param cancelled Polled while scanning; once raised the bitmap is left incomplete.
+     */
+    void evaluate(const QList<TableColumn>& columns, int first, int count, RowBitmap& bitmap,
+                  const std::atomic<bool>* cancelled = nullptr) const;
+
+    /**
+     * Re-tests only the rows set in bitmap, in parallel, clearing those that don't match.
+     * Costs time proportional to the number of set rows.
+     * @param cancelled Polled while scanning; once raised the bitmap is left incomplete.
+     */
+    void refine(const QList<TableColumn>& columns, RowBitmap& bitmap,
+                const std::atomic<bool>* cancelled = nullptr) const;
+
+   private:
+    // Per column, whether each dictionary entry of an encoded filter column matches; empty
+    // for other columns, whose cells are matched one by one.
+    using CodeMatches = std::vector<std::vector<char>>;
+
+    // Matches every dictionary entry of the encoded filter columns once, for those whose
+    // dictionary is smaller than the rows about to be tested.
+    [[nodiscard]] CodeMatches matchCodes(const QList<TableColumn>& columns, qsizetype rows) const;
+
+    // matchesRow() testing encoded columns by code, with buffer for typed cells.
+    [[nodiscard]] bool matchesRow(const QList<TableColumn>& columns, int row,
+                                  const CodeMatches& codes, QString& buffer) const;
+
+    QRegularExpression m_regex;
+    int m_column;
+    QString m_literal;  // The pattern if it is a plain literal, null otherwise
+    QStringList m_requiredLiterals;
+    std::optional<LiteralMatcher> m_fastMatcher;  // Set for plain ASCII literals
+};
+
+/**
+ * Flat proxy showing the rows of a ColumnarTableModel in a given order, so an order computed
+ * off the GUI thread is installed in O(n) with a single layout change instead of a sort.
+ * Without an order it shows the source order.
+ *
+ * An installed order is kept up to date: inserted rows, and rows whose sort columns change,
+ * are moved into place by comparing their cells with a binary search. When too many rows
+ * change at once for that, inserted rows wait at the end, edited ones where they are, and
+ * resortNeeded() asks for a new order.
+ */
+class QT6PLUS_EXPORT RowOrderProxyModel : public QAbstractProxyModel {
+    Q_OBJECT
+
+   public:
+    explicit RowOrderProxyModel(QObject* parent = nullptr);
+
+    // The source must be a ColumnarTableModel.
+    void setSourceModel(QAbstractItemModel* sourceModel) override;
+
+    /**
+     * Shows the source rows in order, which must be sorted by comparer.
+     * @param order Source rows in display order. Rows appended since it was computed may be
+     *     missing; they are placed by key.
+     * @param changedRows Rows edited since order was computed, also placed by key.
+     */
+    void setOrder(const QList<int>& order, RowSorter comparer,
+                  const QList<int>& changedRows = {});
+
+    // Goes back to the source order.
+    void clearOrder();
+
+    // True while an order is installed.
+    [[nodiscard]] bool hasOrder() const { return m_comparer.has_value(); }
+
+    // Source row shown at row, or -1.
+    [[nodiscard]] int sourceRow(int row) const {
+        return row >= 0 && row < m_sourceOf.size() ? m_sourceOf[row] : -1;
+    }
+
+    [[nodiscard]] QModelIndex index(int row, int column,
+                                    const QModelIndex& parent = QModelIndex()) const override;
+    [[nodiscard]] QModelIndex parent(const QModelIndex& child) const override;
+    [[nodiscard]] int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    [[nodiscard]] int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    [[nodiscard]] QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+    [[nodiscard]] QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+    [[nodiscard]] QVariant headerData(int section, Qt::Orientation orientation,
+                                      int role = Qt::DisplayRole) const override;
+
+   signals:
+    // Emitted when rows changed that were too many to place by key.
+    void resortNeeded();
+
+   private:
+    // Shows sourceOf, of which the first placedRows are in key order, in one layout change.
+    void applyOrder(QList<int> sourceOf, int placedRows);
+
+    // Moves rows (source rows) to their place by key, or asks for a resort if too many.
+    void placeRows(const QList<int>& rows);
+
+    // Rebuilds m_rowOf from m_sourceOf.
+    void updateRowOf();
+
+    void sourceRowsInserted(int first, int last);
+    void sourceRowsAboutToBeRemoved(int first, int last);
+    void sourceRowsRemoved(int first, int last);
+    void sourceRowsPermuted(const QList<int>& order);
+    void sourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                           const QList<int>& roles);
+
+    ColumnarTableModel* m_source = nullptr;
+    QList<QMetaObject::Connection> m_sourceConnections;
+    QList<int> m_sourceOf;                // Source row shown at each row
+    QList<int> m_rowOf;                   // Row showing each source row
+    std::optional<RowSorter> m_comparer;  // Keys of the installed order, if any
+    int m_placedRows = 0;                 // Leading rows in key order; the rest wait at the end
+    int m_removedFirst = 0;               // First row of a removal in progress
+};
+
+/**
+ * Sort/filter proxy whose row filter is a precomputed RowBitmap over a ColumnarTableModel.
+ * The bitmap is built in parallel straight from the column stores, then installed with a
+ * single invalidation, so filterAcceptsRow() is a bit test instead of a regex run.
+ * Sorting likewise happens off the GUI thread (see sort()). The order is applied by a
+ * RowOrderProxyModel between the source and this proxy, which is therefore this proxy's
+ * sourceModel(); the source itself keeps its order. Use sourceRow() to map rows back.
+ *
+ * The proxy keeps the bitmap in step with the source: inserted and changed rows are
+ * evaluated, removed rows dropped, and a reset re-evaluates everything, all before the
+ * base class reacts to the same signal.
+ */
+class QT6PLUS_EXPORT TableFilterProxyModel : public QSortFilterProxyModel {
+    Q_OBJECT
+
+   public:
+    explicit TableFilterProxyModel(QObject* parent = nullptr);
+    ~TableFilterProxyModel() override;
+
+    // The source must be a ColumnarTableModel.
+    void setSourceModel(QAbstractItemModel* sourceModel) override;
+
+    // Row of the ColumnarTableModel shown at row of this proxy, or -1.
+    [[nodiscard]] int sourceRow(int row) const;
+
+    /**
+     * Filters the source rows with matcher, evaluated in parallel. When matcher narrows the
+     * current filter (see RowMatcher::narrows) only the rows accepted so far are re-tested;
+     * anything else rescans every row.
+     */
+    void setRowFilter(std::shared_ptr<const RowMatcher> matcher);
+
+    /**
+     * Like setRowFilter(), but evaluates matcher on a pool thread against a snapshot of the
+     * source and installs the result later, emitting rowFilterFinished(). The current filter
+     * stays in effect meanwhile, and source changes made in between are caught up when the
+     * result is installed.
+     *
+     * Every filter request supersedes the ones before it: an older scan still running is
+     * abandoned and its result is never installed.
+     */
+    void setRowFilterAsync(std::shared_ptr<const RowMatcher> matcher);
+
+    // Abandons a pending setRowFilterAsync() request, keeping the current filter.
+    void cancelRowFilterAsync();
+
+    // Matcher of a setRowFilterAsync() request not installed yet, null if none.
+    [[nodiscard]] const std::shared_ptr<const RowMatcher>& pendingRowFilter() const {
+        return m_pendingMatcher;
+    }
+
+    // Removes the row filter, accepting every row.
+    void clearRowFilter();
+
+    [[nodiscard]] const std::shared_ptr<const RowMatcher>& rowFilter() const { return m_matcher; }
+
+    // Rows accepted by the current row filter, one bit per source row.
+    [[nodiscard]] const RowBitmap& acceptedRows() const { return m_accepted; }
+
+    /**
+     * Maintains a TrigramIndex over the source, rebuilt on a pool thread after resets and
+     * reorders and updated in place for appends, edits and removals. While it is ready,
+     * filters with required literals of three or more characters only verify the index's
+     * candidate rows.
+     * @param column Column to index, or -1 for all columns.
+     */
+    void setTrigramIndexEnabled(bool enabled, int column = -1);
+
+    // True when the index covers every source row and will be used by the next filter.
+    [[nodiscard]] bool isTrigramIndexReady() const;
+
+    /**
+     * Sorts by column with sortRows(), so views sorting through the proxy (header clicks,
+     * QTableView::sortByColumn) never sort on the GUI thread. A column of -1 abandons a
+     * running sort and restores the source order.
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    /**
+     * Orders the source rows with sorter on a pool thread, against a snapshot of the source,
+     * and installs the resulting order with RowOrderProxyModel::setOrder(), in O(n): the
+     * proxy and its views remap in a single layout change and sortFinished() is emitted.
+     * The source keeps its order. Other structural changes meanwhile restart the sort; a
+     * newer sort abandons a running one.
+     *
+     * The sort stays in effect: inserted rows, and rows whose sort columns change, are
+     * placed by comparing their cells (RowSorter::compareRows()). Changes of more rows than
+     * that suits, and resets, are sorted again in the background.
+     *
+     * The base class never sorts, so sortColumn() stays -1 and sortOrder() ascending; the
+     * sort in effect is sorter().
+     */
+    void sortRows(std::shared_ptr<const RowSorter> sorter);
+
+    // The installed sort, null if rows are in source order.
+    [[nodiscard]] const std::shared_ptr<const RowSorter>& sorter() const { return m_sorter; }
+
+    // True while a sort has not been applied yet.
+    [[nodiscard]] bool isSortPending() const { return m_pendingSorter != nullptr; }
+
+   signals:
+    // Emitted when a background index build has been installed.
+    void trigramIndexReady();
+
+    /**
+     * Emitted whenever a row filter is installed or cleared.
+     * @param matchCount Number of accepted source rows.
+     * @param elapsedMs Time since the filter was requested.
+     */
+    void rowFilterFinished(int matchCount, qint64 elapsedMs);
+
+    // Emitted when a sort has been applied, with the time since it was requested.
+    void sortFinished(qint64 elapsedMs);
+
+   protected:
+    [[nodiscard]] bool filterAcceptsRow(int sourceRow,
+                                        const QModelIndex& sourceParent) const override;
+
+   private:
+    // Re-evaluates every source row against the current matcher.
+    void rebuildBitmap();
+
+    // Rows the index says may match matcher, if the index can answer for it.
+    [[nodiscard]] std::optional<QList<int>> indexCandidates(const RowMatcher& matcher) const;
+
+    // Starts scanning a snapshot of the source for the pending async matcher.
+    void startFilterScan();
+
+    // Restarts a pending async scan after a source change it can't catch up with.
+    void restartFilterScan();
+
+    // Starts sorting a snapshot of the source with the pending sorter.
+    void startSort();
+
+    // Restarts a pending sort after a source change it can't catch up with.
+    void restartSort();
+
+    // Sorts the source again with the installed sorter, unless that is already pending.
+    void resort();
+
+    // Drops the index and starts building a new one from a snapshot of the source.
+    void scheduleIndexBuild();
+
+    // Keeps the index in step with appended, edited or removed source rows.
+    void indexRowsInserted(int first, int count);
+    void indexRowsChanged(int first, int count);
+    void indexRowsRemoved(int first, int count);
+
+    ColumnarTableModel* m_source = nullptr;
+    RowOrderProxyModel* m_order;  // Between m_source and this proxy
+    std::shared_ptr<const RowMatcher> m_matcher;
+    RowBitmap m_accepted;
+    QList<QMetaObject::Connection> m_sourceConnections;
+
+    // Trigram index (see setTrigramIndexEnabled)
+    bool m_indexEnabled = false;
+    int m_indexColumn = -1;
+    std::optional<TrigramIndex> m_index;
+    bool m_indexBuilding = false;
+    quint64 m_indexGeneration = 0;
+    QList<int> m_indexPendingRows;  // Rows edited while a build was running
+    std::unique_ptr<parallel::TaskGroup> m_tasks;
+
+    // Async filter (see setRowFilterAsync)
+    std::shared_ptr<const RowMatcher> m_pendingMatcher;
+    quint64 m_filterGeneration = 0;
+    int m_filterSnapshotRows = 0;
+    QList<int> m_filterPendingRows;  // Rows edited while the scan was running
+    QElapsedTimer m_filterClock;
+    std::unique_ptr<parallel::TaskGroup> m_filterTasks;
+
+    // Background sort (see sortRows)
+    std::shared_ptr<const RowSorter> m_pendingSorter;
+    quint64 m_sortGeneration = 0;
+    int m_sortSnapshotRows = 0;
+    QList<int> m_sortPendingRows;  // Rows edited while the sort was running
+    QElapsedTimer m_sortClock;
+    std::unique_ptr<parallel::TaskGroup> m_sortTasks;
+
+    std::shared_ptr<const RowSorter> m_sorter;  // Installed sort
+};
+
+#endif  // TABLE_FILTER_H
@@ -0,0 +1,157 @@
+#ifndef TABLE_IMPORT_H
+#define TABLE_IMPORT_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include <optional>
+
+#include "ColumnarTableModel.hpp"
+#include "TableExport.hpp"
+#include "qt6plus_export.hpp"
+
+// A table read from a file, as column stores ready for ColumnarTableModel::resetColumns().
+struct QT6PLUS_EXPORT ImportedTable {
+    QList<TableColumn> columns;
+    QStringList names;  // Column names, if the source had them
+
+    [[nodiscard]] int rowCount() const { return columns.isEmpty() ? 0 : columns[0].size(); }
+    [[nodiscard]] int columnCount() const { return static_cast<int>(columns.size()); }
+};
+
+struct CsvImportOptions {
+    // The first record holds the column names rather than data.
+    bool headerRow = true;
+
+    // Field separator; must be ASCII and not a double quote, CR or LF.
+    char delimiter = ',';
+
+    // Fields equal to one of these are stored empty, like ColumnarTableModel::setNullTokens().
+    QStringList nullTokens;
+};
+
+/**
+ * RFC 4180 CSV reader (UTF-8, optional BOM). Fields may be quoted, with doubled quotes for
+ * embedded ones and line breaks inside quotes kept; records end in LF or CRLF, and blank
+ * lines are skipped. The column count comes from the first record: longer records are
+ * truncated and shorter ones padded with empty cells, as ColumnarTableModel::resetRows() does.
+ *
+ * The input is split at record boundaries found with a parallel quote-parity scan, so a
+ * boundary is never taken inside a quoted field, and the pieces are then parsed concurrently
+ * on the global thread pool, decoding fields straight into per-piece column stores that are
+ * joined at the end. Files are memory-mapped rather than read.
+ */
+class QT6PLUS_EXPORT CsvImporter {
+   public:
+    explicit CsvImporter(CsvImportOptions options = {});
+
+    /**
+     * Reads the CSV file at path into table.
+     * @return false if the file can't be mapped or holds too many rows (see errorString()).
+     */
+    bool read(const QString& path, ImportedTable& table);
+
+    // Reads CSV held in memory, e.g. a mapped file or a downloaded buffer.
+    bool read(QByteArrayView data, ImportedTable& table);
+
+    // Why the last read() failed, empty if it succeeded.
+    [[nodiscard]] const QString& errorString() const { return m_error; }
+
+   private:
+    CsvImportOptions m_options;
+    QString m_error;
+};
+
+/**
+ * Incremental reader for a JSON array of objects or NDJSON (one object per line; any
+ * whitespace between objects works), the layout being told by the first character. Bytes
+ * can be fed as they arrive; each row object is parsed as soon as its closing brace is seen,
+ * and rows are handed out in batches, so memory is bounded by the batch size and the
+ * largest row rather than by the document.
+ *
+ * Values become cell text: strings unescaped, numbers and booleans as written, null as an
+ * empty cell, nested objects and arrays as their JSON text.
+ */
+class QT6PLUS_EXPORT JsonImporter {
+   public:
+    // Receives a batch of rows, cells in column order. Rows may be shorter than
+    // fieldNames() when columns were discovered after them.
+    using RowsReady = std::function<void(const QVector<QStringList>& rows)>;
+
+    /**
+     * @param fieldNames Keys to read, in column order; other keys are ignored. If empty, a
+     * column is added for every key as it is first seen.
+     * @param rowsReady Called with every batchRows rows, and with the rest by finish().
+     * @param batchRows Rows per batch.
+     */
+    JsonImporter(QStringList fieldNames, RowsReady rowsReady, int batchRows = 1000);
+
+    /**
+     * Parses the next bytes of the document. Only the unfinished row is kept between calls.
+     * @return false once the input is malformed (see errorString()).
+     */
+    bool feed(QByteArrayView data);
+
+    /**
+     * Hands out the last rows and checks that the document ended cleanly.
+     * @return false if the input was malformed or ended inside a row or an open array.
+     */
+    bool finish();
+
+    // Feeds the file at path block by block, then finishes.
+    bool read(const QString& path);
+
+    // Keys of the columns, in column order.
+    [[nodiscard]] const QStringList& fieldNames() const { return m_fieldNames; }
+
+    // Rows parsed so far.
+    [[nodiscard]] qint64 rowCount() const { return m_rowCount; }
+
+    // Why parsing failed, empty if it hasn't.
+    [[nodiscard]] const QString& errorString() const { return m_error; }
+
+   private:
+    bool fail(const QString& error);
+
+    // Parses one complete row object into m_rows.
+    bool parseObject(QByteArrayView object);
+
+    // Column of the key at position in its object (as written, still escaped); -1 if ignored.
+    int columnFor(QByteArrayView rawKey, int position);
+
+    // Hands the buffered rows to m_rowsReady.
+    void flush();
+
+    QStringList m_fieldNames;
+    bool m_fixedFields;
+    QHash<QString, int> m_columns;
+    RowsReady m_rowsReady;
+    int m_batchRows;
+    QVector<QStringList> m_rows;
+    qint64 m_rowCount = 0;
+
+    // The previous row's raw keys by position and their columns. Rows usually repeat their
+    // keys in the same order, which spares decoding and hashing them.
+    QList<QByteArray> m_keyOrder;
+    QList<int> m_keyColumns;
+
+    // Scanner state, kept across feed() calls
+    QByteArray m_buffer;           // Bytes not yet consumed, starting with the unfinished row
+    qsizetype m_scanned = 0;       // Bytes of m_buffer already scanned
+    qsizetype m_objectStart = -1;  // Start of the unfinished row in m_buffer, -1 if none
+    qint64 m_consumed = 0;         // Bytes dropped from m_buffer, for error offsets
+    int m_depth = 0;               // Nesting inside the unfinished row
+    bool m_inString = false;
+    bool m_escape = false;
+    bool m_ended = false;          // The array has been closed
+    std::optional<JsonLayout> m_layout;
+
+    QString m_error;
+};
+
+#endif  // TABLE_IMPORT_H
@@ -0,0 +1,112 @@
+#ifndef TABLE_RENDERER_H
+#define TABLE_RENDERER_H
+
+#include <QFont>
+#include <QImage>
+#include <QList>
+#include <QRectF>
+#include <QString>
+#include <QUrl>
+
+#include "TableExport.hpp"
+#include "qt6plus_export.hpp"
+
+class QPagedPaintDevice;
+class QPaintDevice;
+class QPainter;
+class QPdfWriter;
+class QPrinter;
+
+/**
+ * Paints a TableSnapshot as paginated pages with QPainter, without going through HTML and
+ * QTextDocument. Columns are measured once (from the header and a sample of rows) and
+ * scaled to the page width; rows are one line high, with overlong text elided, so
+ * pagination is arithmetic and any page can be painted on its own. Every page repeats the
+ * title, logo and header row.
+ *
+ * Sizes follow the HTML print layout it replaces: lengths are CSS pixels (1/96 inch),
+ * converted with the resolution of the device laid out for.
+ *
+ * Nothing here needs a widget: with a QGuiApplication on the offscreen platform
+ * (QT_QPA_PLATFORM=offscreen), writePdf() produces reports in headless processes.
+ */
+class QT6PLUS_EXPORT TableRenderer {
+   public:
+    /**
+     * @param snapshot Rows to paint and their column names.
+     * @param title Heading painted at the top of every page; none if empty.
+     * @param logo Image painted under the title, 64 px square; none if null.
+     */
+    explicit TableRenderer(TableSnapshot snapshot, QString title = QString(),
+                           QImage logo = QImage());
+
+    // Font for the header and cells. Defaults to the application font.
+    void setFont(const QFont& font);
+
+    /**
+     * Measures columns and paginates for pages of pageRect on device. Call before
+     * pageCount() or paintPage(), and again if the page size changes.
+     */
+    void layout(QPaintDevice* device, const QRectF& pageRect);
+
+    // Number of pages after layout().
+    [[nodiscard]] int pageCount() const { return m_pageCount; }
+
+    // Paints page (0-based) with painter, active on a device like the one laid out for.
+    void paintPage(QPainter& painter, int page) const;
+
+    /**
+     * Lays out for printer's page and prints the pages in its page range, painting each
+     * page as it goes, so time is linear in the rows printed and memory stays bounded.
+     * @return false if painting on printer could not start.
+     */
+    bool print(QPrinter* printer);
+
+    /**
+     * Lays out for writer's page and writes every page to it, without dialogs. The text of
+     * upcoming pages is shaped and elided on the global thread pool while earlier pages are
+     * painted, so long reports take little more than the PDF encoding itself.
+     * @param writer Not yet painted on; its page layout and resolution are used as set.
+     * @return false if painting on writer could not start (e.g. the file can't be opened).
+     */
+    bool writePdf(QPdfWriter* writer);
+
+    // Writes fileName with A4 portrait pages, 15 mm margins and 300 dpi.
+    bool writePdf(const QString& fileName);
+
+    // Loads the image at url: a local file, a qrc: URL or a resource/file path.
+    static QImage loadImage(const QUrl& url);
+
+   private:
+    // Device pixels for a length in CSS pixels.
+    [[nodiscard]] qreal px(qreal cssPixels) const { return cssPixels * m_dpi / 96.0; }
+
+    // Cell text of page, row by row, elided to fit. Safe to call from any thread.
+    [[nodiscard]] QStringList pageText(int page) const;
+
+    void paintPage(QPainter& painter, int page, const QStringList& text) const;
+
+    // Paints pages [first, last] on device, preparing the text of a window of pages in
+    // parallel ahead of painting them in order.
+    bool render(QPagedPaintDevice* device, int first, int last);
+
+    TableSnapshot m_snapshot;
+    QString m_title;
+    QImage m_logo;
+    QFont m_font;
+
+    // Layout (see layout())
+    QRectF m_pageRect;
+    qreal m_dpi = 96;
+    QFont m_titleFont;
+    QFont m_headerFont;  // m_font in bold; both in pixels so metrics need no device
+    QFont m_cellFont;
+    QStringList m_headerText;  // Elided column names
+    QList<qreal> m_columnWidths;
+    qreal m_headingHeight = 0;  // Title and logo block
+    qreal m_rowHeight = 0;
+    int m_rowsPerPage = 1;
+    int m_pageCount = 0;
+};
+
+#endif  // TABLE_RENDERER_H
@@ -0,0 +1,83 @@
+#ifndef TABLE_SORT_H
+#define TABLE_SORT_H
+
+#include <QCollator>
+#include <QList>
+#include <QLocale>
+#include <atomic>
+
+#include "ColumnarTableModel.hpp"
+#include "qt6plus_export.hpp"
+
+// How the cells of a sort column are compared.
+enum class SortKeyType {
+    Auto,      // Number if every non-empty cell parses as one, else DateTime likewise, else Text
+    Text,      // Locale-aware collation
+    Number,    // Numeric value; cells that don't parse sort with the empty ones
+    DateTime,  // ISO 8601 date or date-time; cells that don't parse sort with the empty ones
+};
+
+// One level of a sort: a column, its direction and how its cells compare.
+struct SortKey {
+    int column;
+    Qt::SortOrder order = Qt::AscendingOrder;
+    SortKeyType type = SortKeyType::Auto;
+};
+
+/**
+ * A sort over one or more columns. Every row's key in each sort column (a collation key, or
+ * a parsed number or date) is computed once, in parallel, and rows are then ordered with a
+ * single parallel stable merge sort on the composite key, so no cell is converted or
+ * re-collated per comparison and later columns are only looked at to break ties.
+ * Empty cells sort first in ascending order. Immutable once built.
+ */
+class QT6PLUS_EXPORT RowSorter {
+   public:
+    /**
+     * @param column Column to sort by.
+     * @param order Sort direction.
+     * @param type How cells are compared.
+     * @param locale Locale used for collation and number parsing.
+     */
+    RowSorter(int column, Qt::SortOrder order, SortKeyType type = SortKeyType::Auto,
+              const QLocale& locale = QLocale());
+
+    /**
+     * @param keys Sort levels, most significant first ("department, then date descending").
+     * Keys naming columns that don't exist are ignored.
+     * @param locale Locale used for collation and number parsing.
+     */
+    explicit RowSorter(QList<SortKey> keys, const QLocale& locale = QLocale());
+
+    [[nodiscard]] const QList<SortKey>& keys() const { return m_keys; }
+
+    /**
+     * Sorts rows [0, rows) of columns on the global thread pool. Stable: rows with equal keys
+     * keep their relative order.
+     * @param columns Column stores, typically a snapshot from ColumnarTableModel::columns().
+     * @param cancelled Polled while sorting; once raised an empty list is returned.
+     * @param resolved Receives the keys as they were compared, Auto replaced by the type
+     * detected for each column, for compareRows() to order further rows the same way.
+     * @return The row that belongs at each position.
+     */
+    [[nodiscard]] QList<int> sortedRows(const QList<TableColumn>& columns, int rows,
+                                        const std::atomic<bool>* cancelled = nullptr,
+                                        QList<SortKey>* resolved = nullptr) const;
+
+    /**
+     * Negative, zero or positive as row a sorts before, with or after row b. Cells are
+     * converted on every call instead of once per row, so this is for placing a few rows
+     * into an existing order, such as rows appended after a sort. Auto keys compare as
+     * Text; use the keys resolved by sortedRows(). Not thread-safe (the collator is shared).
+     */
+    [[nodiscard]] int compareRows(const QList<TableColumn>& columns, int a, int b) const;
+
+    [[nodiscard]] const QLocale& locale() const { return m_locale; }
+
+   private:
+    QList<SortKey> m_keys;
+    QLocale m_locale;
+    QCollator m_collator;  // For compareRows()
+};
+
+#endif  // TABLE_SORT_H
@@ -12,22 +12,52 @@
 #include <QTableWidget>
 #include <QTableWidgetItem>
 #include <QtWidgets>
+#include <atomic>
+#include <memory>
 #include <optional>
 
+#include "BoundedQueue.hpp"
+#include "ColumnarTableModel.hpp"
+#include "DatabaseConnection.hpp"
+#include "TableExport.hpp"
+#include "TableFilter.hpp"
+#include "TableImport.hpp"
+#include "TableRenderer.hpp"
 #include "qt6plus_export.hpp"
 
+/**
+ * Paints an HTML document over a print preview. The HTML is parsed once; the document is
+ * laid out again only when the widget's size changes, on a pool thread, and each visible
+ * page is rendered there into a cached pixmap, so repaints just blit.
+ */
 class QT6PLUS_EXPORT HtmlPreviewWidget : public QPrintPreviewWidget {
    public:
     HtmlPreviewWidget(QString html);
+    ~HtmlPreviewWidget() override;
 
    protected:
     void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
 
    private:
+    // Lays the document out for the current size unless it already is, or is being.
+    void scheduleLayout();
+
     QString htmlContent;
+
+    // Parsed by the first layout job. Only used by layout jobs, which run one at a time and
+    // each move it to their thread and back to none.
+    std::shared_ptr<QTextDocument> document;
+    std::unique_ptr<parallel::TaskGroup> layoutTasks;
+    bool layoutRunning = false;
+
+    QSize pageSize;        // Widget size the cached pages were rendered for
+    QList<QPixmap> pages;  // Rendered pages, top to bottom
 };
 
-class QT6PLUS_EXPORT CustomTableModel : public QStandardItemModel {
+// Column store backing TableWidget. Adds editable/disabled column rules on top of
+// ColumnarTableModel.
+class QT6PLUS_EXPORT CustomTableModel : public ColumnarTableModel {
     Q_OBJECT
 
    public:
@@ -81,13 +111,50 @@ class QT6PLUS_EXPORT TableWidget : public QTableView {
     // Sets the column to filter on. Default -1 (all columns)
     void setFilterKeyColumn(int column);
 
+    /**
+     * Enables a trigram search index over the table (or one column), built in the
+     * background after data is loaded and kept up to date on appends and edits.
+     * filterTable() then only verifies candidate rows for literal queries and regexes with
+     * literal parts of at least three characters. Worth it for large tables that are
+     * loaded once and searched often; costs memory proportional to the text size.
+     */
+    void setSearchIndexEnabled(bool enabled, int column = -1);
+
+    /**
+     * Sorts the rows by column without blocking the GUI thread: keys are computed once per
+     * row and sorted in parallel on the global thread pool, then the new order is applied in
+     * one step and sortFinished() is emitted. Header-click sorting goes the same way.
+     * The order lives in the view's proxy, so the model keeps its rows as loaded, rows added
+     * later are sorted into place and model()->sort(-1) restores the loaded order.
+     * @param type How cells compare; Auto detects numeric and ISO date columns.
+     */
+    void sortTable(int column, Qt::SortOrder order = Qt::AscendingOrder,
+                   SortKeyType type = SortKeyType::Auto);
+
+    /**
+     * Stable multi-column sort, e.g. {{department, Qt::AscendingOrder},
+     * {createdAt, Qt::DescendingOrder}}: rows are ordered by the first column, ties by the
+     * second, and so on. Runs as one parallel sort on a composite key, like sortTable(), and
+     * likewise stays in effect as rows are added or edited. Column types are detected as for
+     * SortKeyType::Auto.
+     */
+    void sortTable(const QList<QPair<int, Qt::SortOrder>>& columns);
+
+    // Quiet time filterTableAsync() waits for before filtering. Default 150 ms.
+    void setFilterDebounce(int ms);
+    [[nodiscard]] int filterDebounce() const;
+
     void setContextMenuEnabled(bool enabled);
 
     // Set table horizontal headers.
     // fieldNames should be equal in length to horizontalHeaders(otherwise won't be used)
     // fieldNames are used in generating JSON and CSV data.
+    // schema, if given, sets how each column stores its cells (see
+    // ColumnarTableModel::setColumnTypes()); typed columns sort, filter and export from
+    // native values instead of reparsing text.
     void setHorizontalHeaders(const QStringList& horizontalHeaders,
-                              const QStringList& fields = QStringList());
+                              const QStringList& fields = QStringList(),
+                              const QList<ColumnType>& schema = QList<ColumnType>());
 
     // fieldNames should be equal in length to horizontalHeaders(otherwise won't be used)
     // fieldNames are used in generating JSON and CSV data.
@@ -101,23 +168,141 @@ class QT6PLUS_EXPORT TableWidget : public QTableView {
     void resetHeaders();
 
     /**
-     * Populates the table with data.
+     * Populates the table with data in a single model reset.
      */
     void setData(const QVector<QStringList>& data);
 
+    /**
+     * Brings the table to data in place, for polling: rows are matched to the current ones
+     * by the cell in keyColumn, and only removed, inserted and changed rows are touched
+     * (see ColumnarTableModel::refreshRows()). Unlike setData() there is no model reset, so
+     * selection, the current cell, scroll position, sorting and filtering carry over; a sorted
+     * view places inserted and changed rows by key as they arrive, and the model keeps rows
+     * in the order data gives them.
+     * Falls back to setData() while the table has no columns or keyColumn isn't one.
+     */
+    void refreshData(const QVector<QStringList>& data, int keyColumn);
+
+    /**
+     * Populates the table from a SQL query without materialising the whole result.
+     * The query is read forward-only in pages of pageSize rows as the user scrolls, so the
+     * first paint only waits for one page. Headers set with setHorizontalHeaders() are kept,
+     * otherwise the result's field names are shown.
+     * @param connection Open connection to run the query on. Must stay open while the table
+     * is bound to it (until the next setData(), setQuery() or clearTable()).
+     * @param sql Statement to execute.
+     * @param pageSize Rows read per page.
+     * @param windowRows Maximum rows held in memory, 0 for no limit. When exceeded the oldest
+     * rows are dropped; the vertical header keeps numbering rows from the start of the result.
+     * @return true on success. On failure lastQueryError() describes the error.
+     */
+    bool setQuery(DatabaseConnection& connection, const QString& sql, int pageSize = 1000,
+                  int windowRows = 0);
+
+    // Error from the last setQuery() or page read, empty if none.
+    [[nodiscard]] QString lastQueryError() const;
+
+    /**
+     * Replaces the table with the contents of a CSV file (RFC 4180, UTF-8) in a single model
+     * reset. The file is memory-mapped and parsed in parallel straight into the column
+     * stores; see CsvImporter. Cells equal to a null token ("null", "undefined") load empty.
+     * @param headerRow Whether the first record holds the column names, which then become
+     * the horizontal headers.
+     * @return false if the file can't be read; lastImportError() says why.
+     */
+    bool importCsv(const QString& path, bool headerRow = true);
+
+    /**
+     * Starts an incremental import of a JSON array of objects or NDJSON: clears the rows,
+     * after which feedJson() parses data as it arrives (e.g. a growing network buffer) and
+     * appends rows in batches of batchRows, so memory is bounded by the batch rather than
+     * the document. See JsonImporter.
+     *
+     * Object keys are mapped to the field names if set, other keys being ignored. Otherwise
+     * a column is added for each key as it is first seen, and the keys become the headers
+     * and field names; the next import discovers its keys afresh. Vertical headers are
+     * cleared.
+     */
+    void beginJsonImport(int batchRows = 1000);
+
+    // Parses the next bytes of the document. False once it is malformed (see
+    // lastImportError()); later calls then fail too.
+    bool feedJson(QByteArrayView data);
+
+    // Appends the last rows and ends the import. False if the document was malformed or
+    // incomplete; the rows read before the problem are kept.
+    bool endJsonImport();
+
+    // Imports a JSON or NDJSON file, read in blocks, as beginJsonImport() describes.
+    bool importJson(const QString& path);
+
+    /**
+     * Saves every row with the headers, field names and vertical headers to a binary
+     * snapshot file that loadSnapshot() can reopen instantly.
+     * See ColumnarTableModel::saveSnapshot().
+     */
+    bool saveSnapshot(const QString& path) const;
+
+    /**
+     * Replaces the table with a snapshot written by saveSnapshot(). The file is
+     * memory-mapped and cells are served from it, so this takes milliseconds however many
+     * rows it holds. See ColumnarTableModel::loadSnapshot().
+     */
+    bool loadSnapshot(const QString& path);
+
+    // Error from the last saveSnapshot() or loadSnapshot(), empty if none.
+    [[nodiscard]] const QString& lastSnapshotError() const;
+
+    // Error from the last importCsv() or JSON import, empty if none.
+    [[nodiscard]] const QString& lastImportError() const { return importError; }
+
     // Sets the signals and slots for double click on table. Calls handler with data for
     // the double-clicked row.
     void setDoubleClickHandler(
         std::function<void(int row, int col, const QStringList& data)> handler);
 
+    // Like setDoubleClickHandler(), but hands over the row as a RowRef instead of copying
+    // it into a QStringList. Replaces a handler set with either.
+    void setRowDoubleClickHandler(
+        std::function<void(int row, int col, const RowRef& data)> handler);
+
     // Generates an html table and writes it to a QString that is returned.
+    // Rows are formatted in parallel on the global thread pool.
     QString generateHtmlTable();
 
     // Generates and returns QString containing CSV for the table data.
     QString generateCsvData();
 
+    /**
+     * Writes the rows currently shown (filtered and sorted) to device as RFC 4180 CSV,
+     * headed by the field names or header labels. The rows are snapshotted now and encoded
+     * to UTF-8 in fixed-size chunks on a pool thread, so the table stays usable and memory
+     * stays flat. Progress is reported through exportProgress(), the outcome through
+     * exportFinished() or exportCancelled().
+     * @param device Open for writing and not used elsewhere until the export ends. Files and
+     * buffers work; sockets, which belong to their thread, do not.
+     * @return false if device is not writable or another export is running.
+     */
+    bool exportCsv(QIODevice* device);
+
+    /**
+     * Writes the rows currently shown to device as JSON, like exportCsv(): streamed from a
+     * pool thread without building a document, so memory does not grow with the row count.
+     * Keys are the field names or header labels.
+     * @param options Array or NDJSON layout, and a value type per column.
+     */
+    bool exportJson(QIODevice* device, const JsonExportOptions& options = {});
+
+    // Stops a running export; exportCancelled() is emitted once it has stopped.
+    void cancelExport();
+
+    // True from a successful exportCsv() or exportJson() call until the export ends.
+    [[nodiscard]] bool isExporting() const;
+
     // Generates and returns QString containing JSON for the table data.
     // The valueConverter is required if you want to convert cell data to other types from QString.
+    // Without one, rows are formatted in parallel, and columns typed by the schema are written
+    // as numbers and booleans (see exportJson() for other value types).
     QString generateJsonData(QVariant (*valueConverter)(int col,
                                                         const QString& cellData) = nullptr);
 
@@ -125,18 +310,83 @@ class QT6PLUS_EXPORT TableWidget : public QTableView {
 
     void printTable(QPrinter* printer = nullptr);
 
+    /**
+     * Writes the rows currently shown, with the title and logo, to a PDF file (A4 portrait)
+     * without any dialog; the widget need not be shown. See TableRenderer::writePdf().
+     * @return false if the file could not be written.
+     */
+    bool exportPdf(const QString& fileName);
+
     void appendRow(const QStringList& rowData);
 
+    // Removes the row shown at row, counted like rowCount() after sorting and filtering.
     void deleteRow(int row);
     void clearTable();
 
+    // Appends all rows as a single model insertion and emits tableChanged once.
     void appendRows(const QVector<QStringList>& rowsData);
 
+    /**
+     * Groups any number of mutations (setData, appendRow(s), deleteRow, ...) into one model
+     * reset and a single tableChanged signal, emitted by the outermost endBatch().
+     * Calls nest; every beginBatch() must be matched by an endBatch().
+     */
+    void beginBatch();
+    void endBatch();
+
+    /**
+     * Starts a row feed that worker threads can push rows into with pushRow().
+     * Rows are queued in a lock-free ring buffer and appended on the GUI thread in batches,
+     * each batch as one model insertion.
+     * @param capacity Maximum number of queued rows before pushRow() starts failing.
+     * @param maxLatencyMs Longest time a pushed row waits before it is drained.
+     * @param batchSize Rows per insertion. A drain is also scheduled as soon as this many
+     * rows are waiting.
+     * @note Call from the GUI thread before any producer starts pushing.
+     */
+    void startFeed(int capacity = 65536, int maxLatencyMs = 50, int batchSize = 4096);
+
+    /**
+     * Drains the rows still queued and stops the feed.
+     * @note All producers must have stopped pushing before this is called.
+     */
+    void stopFeed();
+
+    /**
+     * Queues a row for insertion. Thread-safe and lock-free; never blocks.
+     * @return false if no feed is running or the queue is full. A full queue means the
+     * GUI thread is falling behind; it is also reported through feedBackpressure().
+     */
+    bool pushRow(QStringList row);
+
+    // Approximate number of rows queued but not yet in the table.
+    [[nodiscard]] int feedBacklog() const;
+
     [[nodiscard]] auto getAllTableData() const;
 
+    // Text of every selected row, in view order (see selectedSourceRows()). Cells are read
+    // straight from the column stores, rows in parallel.
     [[nodiscard]] QList<QList<QString>> getSelectedRows() const;
+
+    /**
+     * Model rows of the selection in view order, each once. The selection is read as its
+     * QItemSelectionRange spans, which are merged and mapped through the sort/filter proxy,
+     * so a Ctrl+A over millions of rows costs one mapping per row and no index list. Rows
+     * with any selected cell count.
+     */
+    [[nodiscard]] QList<int> selectedSourceRows() const;
+
+    /**
+     * The selected rows as a TableSnapshot named by field names or header labels, for
+     * streaming through TableExporter in fixed-size chunks instead of copying the cells.
+     */
+    [[nodiscard]] TableSnapshot selectionSnapshot() const;
     [[nodiscard]] std::optional<QStringList> getCurrentRow() const;
 
+    // The current row without copying it; invalid if there is none. Valid until the table
+    // next changes.
+    [[nodiscard]] RowRef currentRowRef() const;
+
     void selectRowRange(int startRow, int endRow);
 
    protected:
@@ -147,25 +397,114 @@ class QT6PLUS_EXPORT TableWidget : public QTableView {
    signals:
     void tableSelectionChanged(int row, int column, const QStringList& rowData);
     void rowUpdated(int row, int column, const QStringList& rowData);
+
+    // Same as tableSelectionChanged() and rowUpdated(), with the row as a RowRef: nothing is
+    // copied unless the receiver asks for cells. row is the view row, rowData.row() the model
+    // row. The RowRef is only valid during the emission, so connect directly. The
+    // QStringList signals are only built when something is connected to them.
+    void rowSelected(int row, int column, const RowRef& rowData);
+    void rowEdited(int row, int column, const RowRef& rowData);
     void tableChanged();
 
+    // Emitted after a feed drain when rows were rejected since the last report or the queue
+    // is still more than three quarters full.
+    void feedBackpressure(int backlog, qint64 rejectedRows);
+
+    // Emitted when a filter from filterTable() or filterTableAsync() has been applied, with the
+    // number of matching rows and the time since the filter started running.
+    void filterFinished(int matchCount, qint64 elapsedMs);
+
+    // Emitted when a sort has been applied, with the time it took.
+    void sortFinished(qint64 elapsedMs);
+
+    // Emitted as an export writes rows.
+    void exportProgress(qint64 rowsWritten, qint64 totalRows);
+
+    // Emitted when an export completes or fails. error is empty on success.
+    void exportFinished(bool success, const QString& error);
+
+    // Emitted instead of exportFinished() when an export stopped after cancelExport().
+    void exportCancelled();
+
    public slots:
+    /**
+     * Shows only rows where query matches (any column, or the given column).
+     * Rows are matched in parallel on the global thread pool straight against the cell
+     * storage; an empty query removes the filter.
+     */
     void filterTable(const QString& query,
                      QRegularExpression::PatternOption caseSensitivity =
                          QRegularExpression::CaseInsensitiveOption,
                      int column = -1);
 
+    /**
+     * Same as filterTable() but never blocks the GUI thread, for slots connected to a search
+     * box. The query runs once no new one has arrived for filterDebounce() ms, on a pool thread;
+     * a newer call abandons a scan still in progress. The current rows stay visible until
+     * the result is applied and filterFinished() is emitted.
+     */
+    void filterTableAsync(const QString& query,
+                          QRegularExpression::PatternOption caseSensitivity =
+                              QRegularExpression::CaseInsensitiveOption,
+                          int column = -1);
+
    private:
     std::function<void(int, int, const QStringList&)> doubleClickHandler;
-    void setRowData(int row, const QStringList& rowData);
+    std::function<void(int, int, const RowRef&)> rowDoubleClickHandler;
+
+    // Calls the double-click handler, if any, for the cell at index of the view.
+    void activateRow(const QModelIndex& index);
+
+    // The model row shown at row of the view.
+    [[nodiscard]] RowRef rowRef(int row) const;
 
     bool contextMenuEnabled;
 
+    // beginBatch() nesting depth and whether anything changed inside the batch
+    int batchDepth = 0;
+    bool batchChanged = false;
+
+    // Emits tableChanged, or defers it to endBatch() while batching
+    void notifyTableChanged();
+
+    // Row feed (see startFeed). The queue and counters are shared with producer threads.
+    std::unique_ptr<BoundedQueue<QStringList>> feedQueue;
+    QTimer* feedTimer = nullptr;
+    int feedBatchSize = 0;
+    std::atomic<bool> feedDrainScheduled{false};
+    std::atomic<qint64> feedRejected{0};
+
+    // Moves up to feedBatchSize queued rows into the table.
+    void drainFeed();
+
+    // Debounced filter (see filterTableAsync)
+    QTimer* filterTimer = nullptr;
+    int filterDebounceMs = 150;
+    QString pendingFilterQuery;
+    QRegularExpression::PatternOption pendingFilterOptions =
+        QRegularExpression::CaseInsensitiveOption;
+    int pendingFilterColumn = -1;
+
+    // Starts the filter queued by filterTableAsync().
+    void applyPendingFilter();
+
+    // Background export (see exportCsv and exportJson)
+    std::unique_ptr<parallel::TaskGroup> exportTasks;
+    bool exporting = false;
+
+    // Captures the rows currently shown, or only the selected ones, named by field names
+    // (if preferred and set) or header labels.
+    [[nodiscard]] TableSnapshot snapshot(bool preferFieldNames = true,
+                                         bool selectedOnly = false) const;
+
+    // Runs formatter over a snapshot into device on a pool thread.
+    bool startExport(QIODevice* device, std::shared_ptr<ExportFormatter> formatter);
+
     // Initialize the table model
     CustomTableModel* tableModel;
 
-    // Initialize QSortFilterProxy table model to filter the table.
-    QSortFilterProxyModel* proxyModel;
+    // Sort/filter proxy; filterTable() installs a precomputed row bitmap on it.
+    TableFilterProxyModel* proxyModel;
 
     // Table Headers
     // e.g ["ID", "First Name", "Created At"]
@@ -177,6 +516,19 @@ class QT6PLUS_EXPORT TableWidget : public QTableView {
     // Vertical Headers
     QStringList verticalHeaders;
 
+    // Error raised by setQuery() before reaching the model
+    QString queryError;
+
+    // Error from the last import
+    QString importError;
+
+    // JSON import between beginJsonImport() and endJsonImport()
+    std::unique_ptr<JsonImporter> jsonImport;
+
+    // True while fieldNames are the keys a JSON import discovered rather than names that were
+    // set, so the next import discovers its own.
+    bool jsonFieldsDiscovered = false;
+
     // use fieldNames in generating csv and json
     [[nodiscard]] bool useFields() const;
 
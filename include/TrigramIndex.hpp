@@ -0,0 +1,71 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QStringView>
+#include <atomic>
+#include <optional>
+
+#include "ColumnarTableModel.hpp"
+#include "qt6plus_export.hpp"
+
+/**
+ * Inverted index from case-folded character trigrams to the rows containing them.
+ * Any substring of three or more characters can only occur in rows listed under all of its
+ * trigrams, so a search intersects a few posting lists and verifies just those candidates
+ * instead of scanning every row.
+ *
+ * Posting lists may contain rows that no longer hold a trigram (edits only add entries);
+ * candidates are always verified, so this only costs a little precision.
+ */
+class QT6PLUS_EXPORT TrigramIndex {
+   public:
+    TrigramIndex() = default;
+
+    /**
+     * Indexes rows [0, rowCount) of columns in parallel.
+     * @param columns Column stores, typically a snapshot from ColumnarTableModel::columns().
+     * @param column Column to index, or -1 to index every column per row.
+     * @param cancelled Polled while building; when raised an empty index is returned.
+     */
+    static TrigramIndex build(const QList<TableColumn>& columns, int rowCount, int column,
+                              const std::atomic<bool>* cancelled = nullptr);
+
+    // Column this index covers, -1 for all.
+    [[nodiscard]] int column() const { return m_column; }
+
+    // Number of leading rows indexed.
+    [[nodiscard]] int rowCount() const { return m_rowCount; }
+
+    // Indexes rows appended after the last indexed row.
+    void appendRows(const QList<TableColumn>& columns, int first, int count);
+
+    // Adds the current contents of an already indexed row after an edit.
+    void updateRow(const QList<TableColumn>& columns, int row);
+
+    // Drops rows [first, first + count) from every posting list and renumbers the rows after
+    // them, following a removal from the source without reading any cells.
+    void removeRows(int first, int count);
+
+    /**
+     * Rows that may contain every one of literals, in ascending order.
+     * @return std::nullopt if none of the literals is long enough to use the index.
+     */
+    [[nodiscard]] std::optional<QList<int>> candidates(const QStringList& literals) const;
+
+   private:
+    // Calls fn(key) for every trigram of text.
+    template <typename Fn>
+    static void forEachTrigram(QStringView text, const Fn& fn);
+
+    // Adds row to the posting list of every trigram in its indexed cells.
+    void addRow(const QList<TableColumn>& columns, int row);
+
+    QHash<quint64, QList<int>> m_postings;
+    int m_column = -1;
+    int m_rowCount = 0;
+};
+
+#endif  // TRIGRAM_INDEX_H
@@ -0,0 +1,1488 @@
+#include "../include/ColumnarTableModel.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QLocale>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QStringDecoder>
+#include <QTimeZone>
+#include <QtMath>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include "Parallel.hpp"
+
+// ======================= TableColumn =======================
+
+namespace {
+
+qint64 bitsOf(double value) {
+    qint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double doubleOf(qint64 bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Value of a null cell in a column of type.
+qint64 nullOf(ColumnType type) {
+    return type == ColumnType::Double ? bitsOf(std::numeric_limits<double>::quiet_NaN())
+                                      : TableColumn::nullValue;
+}
+
+qint64 fromDateTime(const QDateTime& dateTime) {
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : TableColumn::nullValue;
+}
+
+// Native value of text in a column of type; null if it is empty or doesn't parse.
+qint64 parseValue(ColumnType type, QStringView text) {
+    const QStringView value = text.trimmed();
+    if (value.isEmpty()) {
+        return nullOf(type);
+    }
+
+    bool ok = false;
+    switch (type) {
+        case ColumnType::String:
+            break;
+
+        case ColumnType::Int64: {
+            const qint64 number = value.toLongLong(&ok);
+            return ok ? number : TableColumn::nullValue;
+        }
+
+        case ColumnType::Double: {
+            const double number = value.toDouble(&ok);
+            return ok ? bitsOf(number) : nullOf(type);
+        }
+
+        case ColumnType::Bool: {
+            auto is = [value](const char* word) {
+                return value.compare(QLatin1String(word), Qt::CaseInsensitive) == 0;
+            };
+            if (is("true") || is("1") || is("yes") || is("on")) {
+                return 1;
+            }
+            if (is("false") || is("0") || is("no") || is("off")) {
+                return 0;
+            }
+            break;
+        }
+
+        case ColumnType::Date: {
+            const QDate date = QDate::fromString(value.toString(), Qt::ISODate);
+            return date.isValid() ? date.toJulianDay() : TableColumn::nullValue;
+        }
+
+        case ColumnType::DateTime: {
+            const QString string = value.toString();
+            QDateTime dateTime = QDateTime::fromString(string, Qt::ISODate);
+            if (!dateTime.isValid()) {
+                dateTime = QDate::fromString(string, Qt::ISODate).startOfDay(QTimeZone::utc());
+            } else if (dateTime.timeSpec() == Qt::LocalTime) {
+                dateTime = QDateTime(dateTime.date(), dateTime.time(), QTimeZone::utc());
+            }
+            return fromDateTime(dateTime);
+        }
+
+        case ColumnType::Time: {
+            const QTime time = QTime::fromString(value.toString(), Qt::ISODate);
+            return time.isValid() ? time.msecsSinceStartOfDay() : TableColumn::nullValue;
+        }
+    }
+    return TableColumn::nullValue;
+}
+
+// Whether an encoded column has collected too many distinct values for its dictionary to
+// pay off.
+bool tooDiverse(int entries, int rows) {
+    return entries > 4096 && entries > rows / 2;
+}
+
+// ISO 8601 text of a native value, with milliseconds only when there are some.
+void formatValue(ColumnType type, qint64 value, QString& out) {
+    switch (type) {
+        case ColumnType::String:
+            break;
+
+        case ColumnType::Int64: {
+            char digits[24];
+            const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+            out = QLatin1String(digits, result.ptr - digits);
+            return;
+        }
+
+        case ColumnType::Double:
+            out = QString::number(doubleOf(value), 'g', QLocale::FloatingPointShortest);
+            return;
+
+        case ColumnType::Bool:
+            out = value != 0 ? QLatin1String("true") : QLatin1String("false");
+            return;
+
+        case ColumnType::Date:
+            out = QDate::fromJulianDay(value).toString(Qt::ISODate);
+            return;
+
+        case ColumnType::DateTime:
+            out = QDateTime::fromMSecsSinceEpoch(value, QTimeZone::utc())
+                      .toString(value % 1000 != 0 ? Qt::ISODateWithMs : Qt::ISODate);
+            return;
+
+        case ColumnType::Time:
+            out = QTime::fromMSecsSinceStartOfDay(int(value))
+                      .toString(value % 1000 != 0 ? Qt::ISODateWithMs : Qt::ISODate);
+            return;
+    }
+    out.clear();
+}
+
+}  // namespace
+
+QStringView TableColumn::text(int row, QString& buffer) const {
+    if (!isTyped()) {
+        return text(row);
+    }
+    if (isNull(row)) {
+        return {};
+    }
+    formatValue(m_type, m_values[row], buffer);
+    return buffer;
+}
+
+bool TableColumn::isNull(int row) const {
+    switch (m_type) {
+        case ColumnType::String:
+            return text(row).isEmpty();
+        case ColumnType::Double:
+            return std::isnan(doubleOf(m_values[row]));
+        default:
+            return m_values[row] == nullValue;
+    }
+}
+
+double TableColumn::number(int row) const {
+    if (m_type == ColumnType::Double) {
+        return doubleOf(m_values[row]);
+    }
+    return m_values[row] == nullValue ? std::numeric_limits<double>::quiet_NaN()
+                                      : double(m_values[row]);
+}
+
+QVariant TableColumn::value(int row) const {
+    if (!isTyped()) {
+        return text(row).toString();
+    }
+    if (isNull(row)) {
+        return {};
+    }
+
+    const qint64 native = m_values[row];
+    switch (m_type) {
+        case ColumnType::Int64:
+            return qlonglong(native);
+        case ColumnType::Double:
+            return doubleOf(native);
+        case ColumnType::Bool:
+            return native != 0;
+        case ColumnType::Date:
+            return QDate::fromJulianDay(native);
+        case ColumnType::DateTime:
+            return QDateTime::fromMSecsSinceEpoch(native, QTimeZone::utc());
+        case ColumnType::Time:
+            return QTime::fromMSecsSinceStartOfDay(int(native));
+        case ColumnType::String:
+            break;
+    }
+    return {};
+}
+
+void TableColumn::setValue(int row, const QVariant& value) {
+    if (!isTyped() || value.userType() == QMetaType::QString || !value.isValid()) {
+        set(row, value.toString());
+        return;
+    }
+
+    qint64 native = nullOf(m_type);
+    bool ok = true;
+    switch (m_type) {
+        case ColumnType::Int64:
+            native = value.toLongLong(&ok);
+            break;
+        case ColumnType::Double:
+            native = bitsOf(value.toDouble(&ok));
+            break;
+        case ColumnType::Bool:
+            native = value.toBool() ? 1 : 0;
+            break;
+        case ColumnType::Date:
+            native = value.toDate().isValid() ? value.toDate().toJulianDay() : nullValue;
+            break;
+        case ColumnType::DateTime:
+            native = fromDateTime(value.toDateTime());
+            break;
+        case ColumnType::Time:
+            native = value.toTime().isValid() ? value.toTime().msecsSinceStartOfDay() : nullValue;
+            break;
+        case ColumnType::String:
+            break;
+    }
+    m_values[row] = ok ? native : nullOf(m_type);
+}
+
+TableColumn TableColumn::converted(ColumnType type) const {
+    if (type == m_type) {
+        return *this;
+    }
+
+    TableColumn column(type);
+    column.reserve(size(), type == ColumnType::String ? m_chars.size() : 0);
+    QString buffer;
+    for (int row = 0; row < size(); ++row) {
+        column.append(text(row, buffer));
+    }
+    return column;
+}
+
+void TableColumn::reserve(int rows, qsizetype chars) {
+    if (isTyped()) {
+        m_values.reserve(rows);
+        return;
+    }
+    if (m_encoded) {
+        m_codes.reserve(rows);
+        return;
+    }
+    m_starts.reserve(rows);
+    m_lengths.reserve(rows);
+    m_chars.reserve(chars);
+}
+
+void TableColumn::append(QStringView text) {
+    if (isTyped()) {
+        m_values.append(parseValue(m_type, text));
+        return;
+    }
+    if (m_encoded) {
+        m_codes.append(codeFor(text));
+        if (tooDiverse(dictionarySize(), size())) {
+            decode();
+        }
+        return;
+    }
+    m_starts.append(m_chars.size());
+    m_lengths.append(static_cast<int>(text.size()));
+    m_chars.append(text);
+}
+
+void TableColumn::appendUtf8(QByteArrayView utf8) {
+    if (isTyped() || m_encoded) {
+        append(QString::fromUtf8(utf8));
+        return;
+    }
+
+    // UTF-16 never takes more code units than UTF-8 takes bytes.
+    const qsizetype start = m_chars.size();
+    m_chars.resize(start + utf8.size());
+
+    QStringDecoder decoder(QStringDecoder::Utf8, QStringDecoder::Flag::Stateless);
+    const QChar* end = decoder.appendToBuffer(m_chars.data() + start, utf8);
+    const qsizetype length = end - (m_chars.constData() + start);
+    m_chars.resize(start + length);
+
+    m_starts.append(start);
+    m_lengths.append(static_cast<int>(length));
+}
+
+void TableColumn::set(int row, QStringView text) {
+    if (isTyped()) {
+        m_values[row] = parseValue(m_type, text);
+        return;
+    }
+    if (m_encoded) {
+        m_codes[row] = codeFor(text);
+        if (tooDiverse(dictionarySize(), size())) {
+            decode();
+        }
+        return;
+    }
+
+    const int oldLength = m_lengths[row];
+
+    if (text.size() <= oldLength) {
+        // Overwrite in place, the tail of the old value becomes garbage.
+        if (!text.isEmpty()) {
+            std::memmove(m_chars.data() + m_starts[row], text.data(),
+                         text.size() * sizeof(QChar));
+        }
+        m_lengths[row] = static_cast<int>(text.size());
+        m_garbage += oldLength - text.size();
+    } else {
+        m_starts[row] = m_chars.size();
+        m_lengths[row] = static_cast<int>(text.size());
+        m_chars.append(text);
+        m_garbage += oldLength;
+    }
+    compactIfWasteful();
+}
+
+bool TableColumn::update(int row, QStringView text) {
+    if (isTyped()) {
+        const qint64 value = parseValue(m_type, text);
+        if (value == m_values[row]) {
+            return false;
+        }
+        m_values[row] = value;
+        return true;
+    }
+    if (this->text(row) == text) {
+        return false;
+    }
+    set(row, text);
+    return true;
+}
+
+void TableColumn::insert(int row, int count) {
+    if (isTyped()) {
+        m_values.insert(row, count, nullOf(m_type));
+        return;
+    }
+    if (m_encoded) {
+        m_codes.insert(row, count, codeFor(QStringView()));
+        return;
+    }
+    m_starts.insert(row, count, m_chars.size());
+    m_lengths.insert(row, count, 0);
+}
+
+void TableColumn::remove(int row, int count) {
+    if (isTyped()) {
+        m_values.remove(row, count);
+        return;
+    }
+    if (m_encoded) {
+        m_codes.remove(row, count);
+        return;
+    }
+    for (int i = row; i < row + count; ++i) {
+        m_garbage += m_lengths[i];
+    }
+    m_starts.remove(row, count);
+    m_lengths.remove(row, count);
+    compactIfWasteful();
+}
+
+void TableColumn::resize(int rows) {
+    if (rows < size()) {
+        remove(rows, size() - rows);
+    } else if (rows > size()) {
+        insert(size(), rows - size());
+    }
+}
+
+void TableColumn::permute(const QList<int>& order) {
+    if (isTyped()) {
+        PodArray<qint64> values(order.size());
+        for (qsizetype i = 0; i < order.size(); ++i) {
+            values[i] = m_values[order[i]];
+        }
+        m_values = std::move(values);
+        return;
+    }
+    if (m_encoded) {
+        PodArray<quint32> codes(order.size());
+        for (qsizetype i = 0; i < order.size(); ++i) {
+            codes[i] = m_codes[order[i]];
+        }
+        m_codes = std::move(codes);
+        return;
+    }
+
+    PodArray<qsizetype> starts(order.size());
+    PodArray<int> lengths(order.size());
+    for (qsizetype i = 0; i < order.size(); ++i) {
+        starts[i] = m_starts[order[i]];
+        lengths[i] = m_lengths[order[i]];
+    }
+    m_starts = std::move(starts);
+    m_lengths = std::move(lengths);
+}
+
+void TableColumn::clear() {
+    m_chars.clear();
+    m_starts.clear();
+    m_lengths.clear();
+    m_values.clear();
+    m_codes.clear();
+    m_slots.clear();
+    m_encoded = false;
+    m_garbage = 0;
+    m_owner.reset();
+}
+
+TableColumn TableColumn::concat(const QList<TableColumn>& parts) {
+    qsizetype rows = 0;
+    qsizetype chars = 0;
+    bool encoded = false;
+    for (const TableColumn& part : parts) {
+        rows += part.size();
+        chars += part.m_chars.size();
+        encoded = encoded || part.m_encoded;
+    }
+
+    // Dictionaries differ between parts, so encoded ones are joined through their text.
+    if (encoded) {
+        TableColumn column;
+        column.reserve(int(rows), 0);
+        for (const TableColumn& part : parts) {
+            for (int row = 0; row < part.size(); ++row) {
+                column.append(part.text(row));
+            }
+        }
+        column.encodeIfRepetitive();
+        return column;
+    }
+
+    TableColumn column(parts.isEmpty() ? ColumnType::String : parts[0].m_type);
+    column.reserve(int(rows), chars);
+    for (const TableColumn& part : parts) {
+        if (column.isTyped()) {
+            column.m_values.append(part.m_values);
+            continue;
+        }
+        const qsizetype offset = column.m_chars.size();
+        column.m_chars.append(part.m_chars);
+        for (qsizetype start : part.m_starts) {
+            column.m_starts.append(start + offset);
+        }
+        column.m_lengths.append(part.m_lengths);
+        column.m_garbage += part.m_garbage;
+    }
+    return column;
+}
+
+TableColumn TableColumn::fromRawData(QStringView chars, const qsizetype* starts,
+                                     const int* lengths, int rows,
+                                     std::shared_ptr<const void> owner) {
+    TableColumn column;
+    column.m_chars = QString::fromRawData(chars.data(), chars.size());
+    column.m_starts = PodArray<qsizetype>::fromRawData(starts, rows);
+    column.m_lengths = PodArray<int>::fromRawData(lengths, rows);
+    column.m_owner = std::move(owner);
+    return column;
+}
+
+TableColumn TableColumn::fromRawData(QStringView chars, const qsizetype* starts,
+                                     const int* lengths, int entries, const quint32* codes,
+                                     int rows, std::shared_ptr<const void> owner) {
+    TableColumn column = fromRawData(chars, starts, lengths, entries, std::move(owner));
+    column.m_encoded = true;
+    column.m_codes = PodArray<quint32>::fromRawData(codes, rows);
+    return column;
+}
+
+TableColumn TableColumn::fromRawData(ColumnType type, const qint64* values, int rows,
+                                     std::shared_ptr<const void> owner) {
+    TableColumn column(type);
+    column.m_values = PodArray<qint64>::fromRawData(values, rows);
+    column.m_owner = std::move(owner);
+    return column;
+}
+
+void TableColumn::compactIfWasteful() {
+    // Small buffers are not worth rewriting.
+    if (m_garbage < 4096 || m_garbage < m_chars.size() / 2) {
+        return;
+    }
+    squeeze();
+}
+
+void TableColumn::squeeze() {
+    if (m_garbage == 0 || m_encoded) {
+        return;
+    }
+
+    QString chars;
+    chars.reserve(m_chars.size() - m_garbage);
+    for (int row = 0; row < size(); ++row) {
+        const qsizetype start = chars.size();
+        chars.append(text(row));
+        m_starts[row] = start;
+    }
+    m_chars = std::move(chars);
+    m_garbage = 0;
+}
+
+bool TableColumn::encodeIfRepetitive(int maxRatio) {
+    if (isTyped() || m_encoded) {
+        return m_encoded;
+    }
+    const int rows = size();
+    if (rows < 64) {
+        return false;
+    }
+
+    // Codes are assigned in one pass, giving up as soon as the dictionary outgrows its cap.
+    const int maxEntries = rows / qMax(1, maxRatio);
+    TableColumn encoded;
+    encoded.m_encoded = true;
+    encoded.m_codes.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        encoded.m_codes.append(encoded.codeFor(text(row)));
+        if (encoded.dictionarySize() > maxEntries) {
+            return false;
+        }
+    }
+    *this = std::move(encoded);
+    return true;
+}
+
+quint32 TableColumn::codeFor(QStringView text) {
+    // At most half the slots are used, so probe sequences stay short.
+    if (m_slots.size() < 2 * (m_lengths.size() + 1)) {
+        rehash(qsizetype(qNextPowerOfTwo(quint64(4 * (m_lengths.size() + 1)))));
+    }
+
+    const qsizetype mask = m_slots.size() - 1;
+    for (qsizetype slot = qHash(text) & mask;; slot = (slot + 1) & mask) {
+        const quint32 stored = std::as_const(m_slots)[slot];
+        if (stored == 0) {
+            const auto code = static_cast<quint32>(m_lengths.size());
+            m_starts.append(m_chars.size());
+            m_lengths.append(static_cast<int>(text.size()));
+            m_chars.append(text);
+            m_slots[slot] = code + 1;
+            return code;
+        }
+        if (entry(stored - 1) == text) {
+            return stored - 1;
+        }
+    }
+}
+
+void TableColumn::rehash(qsizetype slots) {
+    m_slots = PodArray<quint32>(slots);
+    std::fill_n(m_slots.data(), slots, 0U);
+
+    const qsizetype mask = slots - 1;
+    for (qsizetype code = 0; code < m_lengths.size(); ++code) {
+        qsizetype slot = qHash(entry(code)) & mask;
+        while (m_slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        m_slots[slot] = static_cast<quint32>(code + 1);
+    }
+}
+
+void TableColumn::decode() {
+    TableColumn plain;
+    plain.reserve(size(), 0);
+    for (int row = 0; row < size(); ++row) {
+        plain.append(text(row));
+    }
+    *this = std::move(plain);
+}
+
+// ======================= ColumnarTableModel =======================
+
+ColumnarTableModel::ColumnarTableModel(QObject* parent) : QAbstractTableModel(parent) {}
+
+ColumnarTableModel::~ColumnarTableModel() = default;
+
+int ColumnarTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+int ColumnarTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(m_columns.size());
+}
+
+QVariant ColumnarTableModel::data(const QModelIndex& index, int role) const {
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid)) {
+        return {};
+    }
+
+    if (role == Qt::DisplayRole) {
+        return text(index.row(), index.column());
+    }
+    if (role == Qt::EditRole) {
+        return m_columns[index.column()].value(index.row());
+    }
+    return {};
+}
+
+bool ColumnarTableModel::setData(const QModelIndex& index, const QVariant& value, int role) {
+    if (role != Qt::EditRole || !checkIndex(index, CheckIndexOption::IndexIsValid)) {
+        return false;
+    }
+
+    m_columns[index.column()].setValue(index.row(), value);
+    if (!inBatch()) {
+        emit dataChanged(index, index, {Qt::DisplayRole, Qt::EditRole});
+    }
+    return true;
+}
+
+QVariant ColumnarTableModel::headerData(int section, Qt::Orientation orientation,
+                                        int role) const {
+    if (role == Qt::DisplayRole || role == Qt::EditRole) {
+        const QStringList& labels =
+            orientation == Qt::Horizontal ? m_horizontalLabels : m_verticalLabels;
+        if (section >= 0 && section < labels.size()) {
+            return labels[section];
+        }
+
+        // Keep numbering absolute query rows when the window dropped leading rows.
+        if (orientation == Qt::Vertical && role == Qt::DisplayRole && m_droppedRows > 0) {
+            return m_droppedRows + section + 1;
+        }
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool ColumnarTableModel::setHeaderData(int section, Qt::Orientation orientation,
+                                       const QVariant& value, int role) {
+    const int count = orientation == Qt::Horizontal ? columnCount() : rowCount();
+    if (role != Qt::EditRole || section < 0 || section >= count) {
+        return false;
+    }
+
+    QStringList& labels = orientation == Qt::Horizontal ? m_horizontalLabels : m_verticalLabels;
+    while (labels.size() <= section) {
+        labels.append(QString());
+    }
+    labels[section] = value.toString();
+
+    if (!inBatch()) {
+        emit headerDataChanged(orientation, section, section);
+    }
+    return true;
+}
+
+Qt::ItemFlags ColumnarTableModel::flags(const QModelIndex& index) const {
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsEditable;
+}
+
+bool ColumnarTableModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && hasPendingQuery();
+}
+
+void ColumnarTableModel::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) {
+        return;
+    }
+
+    const int columns = columnCount();
+
+    QVector<QStringList> page;
+    page.reserve(m_pageSize);
+    while (page.size() < m_pageSize && m_query->next()) {
+        QStringList row;
+        row.reserve(columns);
+        for (int col = 0; col < columns; ++col) {
+            const QVariant value = m_query->value(col);
+            row.append(value.isNull() ? QString() : value.toString());
+        }
+        page.append(std::move(row));
+    }
+
+    if (page.size() < m_pageSize) {
+        // Exhausted or failed; either way there is nothing more to read.
+        if (m_query->lastError().isValid()) {
+            m_queryError = m_query->lastError().text();
+        }
+        m_query->finish();
+    }
+
+    appendRows(page);
+
+    if (m_windowRows > 0 && m_rowCount > m_windowRows) {
+        const int excess = m_rowCount - m_windowRows;
+        removeRows(0, excess);
+        m_droppedRows += excess;
+    }
+}
+
+bool ColumnarTableModel::insertRows(int row, int count, const QModelIndex& parent) {
+    if (parent.isValid() || count <= 0 || row < 0 || row > m_rowCount) {
+        return false;
+    }
+
+    if (!inBatch()) {
+        beginInsertRows(parent, row, row + count - 1);
+    }
+    for (TableColumn& column : m_columns) {
+        column.insert(row, count);
+    }
+    m_rowCount += count;
+    if (!inBatch()) {
+        endInsertRows();
+    }
+    return true;
+}
+
+bool ColumnarTableModel::removeRows(int row, int count, const QModelIndex& parent) {
+    if (parent.isValid() || count <= 0 || row < 0 || row + count > m_rowCount) {
+        return false;
+    }
+
+    if (!inBatch()) {
+        beginRemoveRows(parent, row, row + count - 1);
+    }
+    for (TableColumn& column : m_columns) {
+        column.remove(row, count);
+    }
+    m_rowCount -= count;
+    if (m_verticalLabels.size() > row) {
+        m_verticalLabels.remove(row, std::min<qsizetype>(count, m_verticalLabels.size() - row));
+    }
+    if (!inBatch()) {
+        endRemoveRows();
+    }
+    return true;
+}
+
+bool ColumnarTableModel::insertColumns(int column, int count, const QModelIndex& parent) {
+    if (parent.isValid() || count <= 0 || column < 0 || column > columnCount()) {
+        return false;
+    }
+
+    if (!inBatch()) {
+        beginInsertColumns(parent, column, column + count - 1);
+    }
+    // Types set ahead for columns that don't exist yet apply as they are appended; columns
+    // inserted before existing ones hold strings, and the types after them move along.
+    if (column < columnCount() && column < m_columnTypes.size()) {
+        m_columnTypes.insert(column, count, ColumnType::String);
+    }
+    for (int i = 0; i < count; ++i) {
+        TableColumn empty(columnType(column + i));
+        empty.resize(m_rowCount);
+        m_columns.insert(column + i, empty);
+    }
+    if (!inBatch()) {
+        endInsertColumns();
+    }
+    return true;
+}
+
+bool ColumnarTableModel::removeColumns(int column, int count, const QModelIndex& parent) {
+    if (parent.isValid() || count <= 0 || column < 0 || column + count > columnCount()) {
+        return false;
+    }
+
+    if (!inBatch()) {
+        beginRemoveColumns(parent, column, column + count - 1);
+    }
+    m_columns.remove(column, count);
+    if (m_columnTypes.size() > column) {
+        m_columnTypes.remove(column, std::min<qsizetype>(count, m_columnTypes.size() - column));
+    }
+    if (m_horizontalLabels.size() > column) {
+        m_horizontalLabels.remove(column,
+                                  std::min<qsizetype>(count, m_horizontalLabels.size() - column));
+    }
+    if (!inBatch()) {
+        endRemoveColumns();
+    }
+    return true;
+}
+
+void ColumnarTableModel::setRowCount(int rows) {
+    if (rows > m_rowCount) {
+        insertRows(m_rowCount, rows - m_rowCount);
+    } else if (rows < m_rowCount) {
+        removeRows(rows, m_rowCount - rows);
+    }
+}
+
+void ColumnarTableModel::setColumnCount(int columns) {
+    if (columns > columnCount()) {
+        insertColumns(columnCount(), columns - columnCount());
+    } else if (columns < columnCount()) {
+        removeColumns(columns, columnCount() - columns);
+    }
+}
+
+void ColumnarTableModel::setHorizontalHeaderLabels(const QStringList& labels) {
+    if (labels.size() > columnCount()) {
+        setColumnCount(static_cast<int>(labels.size()));
+    }
+
+    m_horizontalLabels = labels;
+    if (columnCount() > 0 && !inBatch()) {
+        emit headerDataChanged(Qt::Horizontal, 0, columnCount() - 1);
+    }
+}
+
+void ColumnarTableModel::setVerticalHeaderLabels(const QStringList& labels) {
+    if (labels.size() > m_rowCount) {
+        setRowCount(static_cast<int>(labels.size()));
+    }
+
+    m_verticalLabels = labels;
+    if (m_rowCount > 0 && !inBatch()) {
+        emit headerDataChanged(Qt::Vertical, 0, m_rowCount - 1);
+    }
+}
+
+void ColumnarTableModel::clear() {
+    releaseQuery();
+    beginBatch();
+    m_columns.clear();
+    m_horizontalLabels.clear();
+    m_verticalLabels.clear();
+    m_rowCount = 0;
+    endBatch();
+}
+
+QStringView ColumnarTableModel::cell(int row, int column) const {
+    return m_columns[column].text(row);
+}
+
+QString ColumnarTableModel::text(int row, int column) const {
+    QString buffer;
+    return m_columns[column].text(row, buffer).toString();
+}
+
+void ColumnarTableModel::setText(int row, int column, QStringView text) {
+    m_columns[column].set(row, text);
+
+    if (!inBatch()) {
+        const QModelIndex changed = index(row, column);
+        emit dataChanged(changed, changed, {Qt::DisplayRole, Qt::EditRole});
+    }
+}
+
+void ColumnarTableModel::setColumnTypes(const QList<ColumnType>& types) {
+    beginBatch();
+    m_columnTypes = types;
+    TableColumn* columns = m_columns.data();  // Detached once, before the workers write
+    parallel::forEach(m_columns.size(), [this, columns](qsizetype col) {
+        columns[col] = columns[col].converted(columnType(int(col)));
+        columns[col].encodeIfRepetitive();
+    });
+    endBatch();
+}
+
+void ColumnarTableModel::setNullTokens(const QStringList& tokens) {
+    m_nullTokens = tokens;
+}
+
+void ColumnarTableModel::resetRows(const QVector<QStringList>& rows, int columns) {
+    releaseQuery();
+    beginBatch();
+
+    const int rowCount = static_cast<int>(rows.size());
+
+    // Size every column buffer up front so loading does not reallocate as it grows.
+    QList<qsizetype> chars(columns, 0);
+    for (const QStringList& row : rows) {
+        const int n = std::min(columns, static_cast<int>(row.size()));
+        for (int col = 0; col < n; ++col) {
+            chars[col] += row[col].size();
+        }
+    }
+
+    m_columns.clear();
+    m_columns.reserve(columns);
+    for (int col = 0; col < columns; ++col) {
+        m_columns.append(TableColumn(columnType(col)));
+        m_columns[col].reserve(rowCount, chars[col]);
+    }
+
+    m_rowCount = 0;
+    for (const QStringList& row : rows) {
+        appendRowCells(row);
+    }
+    encodeRepetitiveColumns();
+
+    endBatch();
+}
+
+void ColumnarTableModel::resetColumns(QList<TableColumn> columns) {
+    releaseQuery();
+    beginBatch();
+
+    m_rowCount = columns.isEmpty() ? 0 : columns[0].size();
+    TableColumn* data = columns.data();
+    parallel::forEach(columns.size(), [this, data](qsizetype col) {
+        TableColumn& column = data[col];
+        column.resize(m_rowCount);
+        if (column.type() != columnType(int(col))) {
+            column = column.converted(columnType(int(col)));
+        }
+        column.encodeIfRepetitive();
+    });
+    m_columns = std::move(columns);
+
+    endBatch();
+}
+
+bool ColumnarTableModel::refreshRows(const QVector<QStringList>& rows, int keyColumn) {
+    if (keyColumn < 0 || keyColumn >= columnCount()) {
+        return false;
+    }
+    releaseQuery();
+
+    // The new keys, stored as the key column stores them so they compare like for like.
+    TableColumn newKeys(m_columns[keyColumn].type());
+    newKeys.reserve(static_cast<int>(rows.size()), 0);
+    for (const QStringList& row : rows) {
+        newKeys.append(loadedText(row, keyColumn));
+    }
+
+    // New row of each current row and current row of each new row, -1 if unmatched
+    QList<int> newRowOf(m_rowCount, -1);
+    QList<int> oldRowOf(rows.size(), -1);
+    auto match = [&](auto keyOf) {
+        QHash<decltype(keyOf(newKeys, 0)), int> newRows;
+        newRows.reserve(newKeys.size());
+        for (int row = 0; row < newKeys.size(); ++row) {
+            const auto key = keyOf(newKeys, row);
+            if (!newRows.contains(key)) {
+                newRows.insert(key, row);
+            }
+        }
+        const TableColumn& keys = m_columns[keyColumn];
+        for (int row = 0; row < m_rowCount; ++row) {
+            const auto it = newRows.constFind(keyOf(keys, row));
+            if (it != newRows.cend() && oldRowOf[*it] < 0) {
+                oldRowOf[*it] = row;
+                newRowOf[row] = *it;
+            }
+        }
+    };
+    if (newKeys.isTyped()) {
+        match([](const TableColumn& column, int row) { return column.values()[row]; });
+    } else {
+        match([](const TableColumn& column, int row) { return column.text(row); });
+    }
+
+    // Removals, bottom up so the rows above keep their numbers
+    for (int row = m_rowCount - 1; row >= 0; --row) {
+        if (newRowOf[row] >= 0) {
+            continue;
+        }
+        int first = row;
+        while (first > 0 && newRowOf[first - 1] < 0) {
+            --first;
+        }
+        removeRows(first, row - first + 1);
+        row = first;
+    }
+
+    // The rows left must be in the new relative order before anything is inserted.
+    QList<int> kept;
+    kept.reserve(m_rowCount);
+    for (int newRow : newRowOf) {
+        if (newRow >= 0) {
+            kept.append(newRow);
+        }
+    }
+    if (!std::is_sorted(kept.cbegin(), kept.cend())) {
+        QList<int> order(kept.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&kept](int a, int b) { return kept[a] < kept[b]; });
+        permuteRows(order);
+    }
+
+    // Insertions, top down: every new row before a run is in place by the time it's reached.
+    for (int row = 0; row < rows.size(); ++row) {
+        if (oldRowOf[row] >= 0) {
+            continue;
+        }
+        int last = row;
+        while (last + 1 < rows.size() && oldRowOf[last + 1] < 0) {
+            ++last;
+        }
+        insertRowCells(row, rows, row, last - row + 1);
+        row = last;
+    }
+
+    // Updates: row i now holds new row i. Changed rows are reported in runs, each spanning
+    // the columns that changed in it.
+    int runFirst = -1;
+    int runLeft = 0;
+    int runRight = 0;
+    auto flush = [&](int runLast) {
+        if (runFirst >= 0 && !inBatch()) {
+            emit dataChanged(index(runFirst, runLeft), index(runLast, runRight),
+                             {Qt::DisplayRole, Qt::EditRole});
+        }
+        runFirst = -1;
+    };
+    for (int row = 0; row < rows.size(); ++row) {
+        int left = -1;
+        int right = -1;
+        if (oldRowOf[row] >= 0) {
+            for (int col = 0; col < m_columns.size(); ++col) {
+                if (m_columns[col].update(row, loadedText(rows[row], col))) {
+                    left = left < 0 ? col : left;
+                    right = col;
+                }
+            }
+        }
+        if (left < 0) {
+            flush(row - 1);
+            continue;
+        }
+        if (runFirst < 0) {
+            runFirst = row;
+            runLeft = left;
+            runRight = right;
+        } else {
+            runLeft = std::min(runLeft, left);
+            runRight = std::max(runRight, right);
+        }
+    }
+    flush(static_cast<int>(rows.size()) - 1);
+    return true;
+}
+
+void ColumnarTableModel::appendRows(const QVector<QStringList>& rows) {
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    const int first = m_rowCount;
+    const int last = first + static_cast<int>(rows.size()) - 1;
+
+    if (!inBatch()) {
+        beginInsertRows(QModelIndex(), first, last);
+    }
+    for (const QStringList& row : rows) {
+        appendRowCells(row);
+    }
+    // Columns get a chance at dictionary encoding each time the row count doubles, which
+    // keeps the scans linear in the rows appended overall.
+    if (qNextPowerOfTwo(quint32(first)) <= quint32(m_rowCount)) {
+        encodeRepetitiveColumns();
+    }
+    if (!inBatch()) {
+        endInsertRows();
+    }
+}
+
+void ColumnarTableModel::permuteRows(const QList<int>& order) {
+    if (order.size() != m_rowCount) {
+        return;
+    }
+
+    if (!inBatch()) {
+        emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    }
+
+    for (TableColumn& column : m_columns) {
+        column.permute(order);
+    }
+    // Labels naming every row move with their rows; partial ones label positions.
+    if (m_verticalLabels.size() == m_rowCount) {
+        QStringList labels;
+        labels.reserve(m_rowCount);
+        for (int row : order) {
+            labels.append(m_verticalLabels[row]);
+        }
+        m_verticalLabels = std::move(labels);
+    }
+
+    if (!inBatch()) {
+        QList<int> newRow(m_rowCount);
+        for (int i = 0; i < m_rowCount; ++i) {
+            newRow[order[i]] = i;
+        }
+
+        const QModelIndexList from = persistentIndexList();
+        QModelIndexList to;
+        to.reserve(from.size());
+        for (const QModelIndex& index : from) {
+            to.append(this->index(newRow[index.row()], index.column()));
+        }
+        changePersistentIndexList(from, to);
+
+        emit rowsPermuted(order);
+        emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+    }
+}
+
+void ColumnarTableModel::beginBatch() {
+    if (m_batchDepth++ == 0) {
+        beginResetModel();
+    }
+}
+
+void ColumnarTableModel::endBatch() {
+    if (m_batchDepth > 0 && --m_batchDepth == 0) {
+        endResetModel();
+    }
+}
+
+bool ColumnarTableModel::bindQuery(const QSqlDatabase& database, const QString& sql, int pageSize,
+                                   int windowRows) {
+    auto query = std::make_unique<QSqlQuery>(database);
+    query->setForwardOnly(true);
+    if (!query->exec(sql)) {
+        m_queryError = QString("Query execution failed: %1").arg(query->lastError().text());
+        return false;
+    }
+
+    const QSqlRecord record = query->record();
+    QStringList labels;
+    for (int col = 0; col < record.count(); ++col) {
+        labels.append(record.fieldName(col));
+    }
+
+    beginBatch();
+    resetRows({}, static_cast<int>(labels.size()));
+    m_horizontalLabels = labels;
+    m_verticalLabels.clear();
+
+    m_query = std::move(query);
+    m_queryError.clear();
+    m_pageSize = qMax(1, pageSize);
+    m_windowRows = windowRows > 0 ? qMax(windowRows, m_pageSize) : 0;
+
+    // The first page is read up front so the view has something to paint.
+    fetchMore(QModelIndex());
+    endBatch();
+    return true;
+}
+
+bool ColumnarTableModel::hasPendingQuery() const {
+    return m_query && m_query->isActive();
+}
+
+void ColumnarTableModel::releaseQuery() {
+    m_query.reset();
+    m_droppedRows = 0;
+}
+
+void ColumnarTableModel::encodeRepetitiveColumns() {
+    TableColumn* columns = m_columns.data();
+    parallel::forEach(m_columns.size(), [columns](qsizetype col) {
+        columns[col].encodeIfRepetitive();
+    });
+}
+
+QStringView ColumnarTableModel::loadedText(const QStringList& cells, int column) const {
+    const QStringView text = column < cells.size() ? QStringView(cells[column]) : QStringView();
+    if (!text.isEmpty() && m_nullTokens.contains(text)) {
+        return {};
+    }
+    return text;
+}
+
+void ColumnarTableModel::appendRowCells(const QStringList& cells) {
+    for (int col = 0; col < m_columns.size(); ++col) {
+        m_columns[col].append(loadedText(cells, col));
+    }
+    ++m_rowCount;
+}
+
+void ColumnarTableModel::insertRowCells(int row, const QVector<QStringList>& rows, int from,
+                                        int count) {
+    if (!inBatch()) {
+        beginInsertRows(QModelIndex(), row, row + count - 1);
+    }
+    for (int col = 0; col < m_columns.size(); ++col) {
+        TableColumn& column = m_columns[col];
+        column.insert(row, count);
+        for (int i = 0; i < count; ++i) {
+            column.set(row + i, loadedText(rows[from + i], col));
+        }
+    }
+    m_rowCount += count;
+    if (!inBatch()) {
+        endInsertRows();
+    }
+}
+
+// ======================= Snapshot files =======================
+
+namespace {
+
+/*
+ * Snapshot layout, in native byte order: a header, one directory entry per column, then
+ * each column's text buffer (UTF-16), cell offsets (qsizetype) and cell lengths (int) --
+ * or for an encoded column its dictionary laid out the same way and cell codes (quint32),
+ * or a typed column's values (qint64) -- each 8-byte aligned so they can be used in place
+ * once mapped, and finally the labels and metadata as a QDataStream block.
+ */
+constexpr char snapshotMagic[8] = {'Q', 'T', '6', 'P', 'S', 'N', 'A', 'P'};
+constexpr quint32 snapshotVersion = 3;
+constexpr quint16 byteOrderMark = 0xFEFF;
+
+struct SnapshotHeader {
+    char magic[8];
+    quint32 version;
+    quint16 byteOrder;   // byteOrderMark as written; reads differently on the other endianness
+    quint16 offsetSize;  // sizeof(qsizetype) of the writer
+    qint64 rows;
+    qint64 columns;
+    qint64 metaOffset;
+    qint64 metaSize;
+};
+
+struct SnapshotColumn {
+    qint64 type;  // ColumnType
+    qint64 values;
+    qint64 codes;    // 0 unless encoded
+    qint64 entries;  // Dictionary entries of an encoded column
+    qint64 chars;
+    qint64 charCount;
+    qint64 starts;
+    qint64 lengths;
+};
+
+qint64 aligned(qint64 offset) {
+    return (offset + 7) & ~qint64(7);
+}
+
+}  // namespace
+
+bool ColumnarTableModel::saveSnapshot(const QString& path, const QVariantMap& metadata) const {
+    m_snapshotError.clear();
+
+    QByteArray meta;
+    {
+        QDataStream stream(&meta, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << m_horizontalLabels << m_verticalLabels << metadata;
+    }
+
+    // Squeezed copies, so replaced text isn't written; columns without any stay shared.
+    QList<TableColumn> columns = m_columns;
+    for (TableColumn& column : columns) {
+        column.squeeze();
+    }
+
+    // Lay everything out first; blocks are then written in order, padded to their offsets.
+    SnapshotHeader header{};
+    std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+    header.version = snapshotVersion;
+    header.byteOrder = byteOrderMark;
+    header.offsetSize = sizeof(qsizetype);
+    header.rows = m_rowCount;
+    header.columns = columns.size();
+
+    qint64 end = sizeof(SnapshotHeader) + columns.size() * qint64(sizeof(SnapshotColumn));
+    auto place = [&end](qint64 bytes) {
+        const qint64 offset = aligned(end);
+        end = offset + bytes;
+        return offset;
+    };
+
+    QList<SnapshotColumn> directory;
+    for (const TableColumn& column : columns) {
+        SnapshotColumn entry{};
+        entry.type = qint64(column.type());
+        if (column.isTyped()) {
+            entry.values = place(m_rowCount * qint64(sizeof(qint64)));
+        } else {
+            // Text offsets and lengths are per cell, or per dictionary entry if encoded.
+            const qint64 spans = column.isEncoded() ? column.dictionarySize() : m_rowCount;
+            entry.charCount = column.chars().size();
+            entry.chars = place(entry.charCount * qint64(sizeof(QChar)));
+            entry.starts = place(spans * qint64(sizeof(qsizetype)));
+            entry.lengths = place(spans * qint64(sizeof(int)));
+            if (column.isEncoded()) {
+                entry.entries = spans;
+                entry.codes = place(m_rowCount * qint64(sizeof(quint32)));
+            }
+        }
+        directory.append(entry);
+    }
+    header.metaOffset = place(meta.size());
+    header.metaSize = meta.size();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_snapshotError = file.errorString();
+        return false;
+    }
+
+    static const char padding[8] = {};
+    auto writeAt = [&file](qint64 offset, const void* data, qint64 size) {
+        const qint64 gap = offset - file.pos();
+        return (gap == 0 || file.write(padding, gap) == gap) &&
+               file.write(static_cast<const char*>(data), size) == size;
+    };
+
+    bool ok = writeAt(0, &header, sizeof(header)) &&
+              writeAt(sizeof(header), directory.constData(),
+                      directory.size() * qint64(sizeof(SnapshotColumn)));
+    for (qsizetype col = 0; ok && col < columns.size(); ++col) {
+        const TableColumn& column = columns[col];
+        const SnapshotColumn& entry = directory[col];
+        if (column.isTyped()) {
+            ok = writeAt(entry.values, column.values(), m_rowCount * qint64(sizeof(qint64)));
+            continue;
+        }
+        const qint64 spans = column.isEncoded() ? entry.entries : m_rowCount;
+        ok = writeAt(entry.chars, column.chars().data(), entry.charCount * qint64(sizeof(QChar))) &&
+             writeAt(entry.starts, column.starts(), spans * qint64(sizeof(qsizetype))) &&
+             writeAt(entry.lengths, column.lengths(), spans * qint64(sizeof(int)));
+        if (ok && column.isEncoded()) {
+            ok = writeAt(entry.codes, column.codes(), m_rowCount * qint64(sizeof(quint32)));
+        }
+    }
+    ok = ok && writeAt(header.metaOffset, meta.constData(), meta.size());
+
+    if (!ok || !file.commit()) {
+        m_snapshotError = file.errorString();
+        file.cancelWriting();
+        return false;
+    }
+    return true;
+}
+
+bool ColumnarTableModel::loadSnapshot(const QString& path, QVariantMap* metadata) {
+    m_snapshotError.clear();
+
+    // Shared by every column laid over the mapping, which lasts until the last one goes.
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        m_snapshotError = file->errorString();
+        return false;
+    }
+
+    const qint64 size = file->size();
+    auto invalid = [this, &path]() {
+        m_snapshotError = QString("Not a table snapshot: %1").arg(path);
+        return false;
+    };
+    if (size < qint64(sizeof(SnapshotHeader))) {
+        return invalid();
+    }
+    const uchar* base = file->map(0, size);
+    if (base == nullptr) {
+        m_snapshotError = file->errorString();
+        return false;
+    }
+
+    // Whether [offset, offset + bytes) lies in the file, aligned for its elements.
+    auto fits = [size](qint64 offset, qint64 bytes, qint64 alignment) {
+        return offset >= 0 && bytes >= 0 && offset <= size && bytes <= size - offset &&
+               offset % alignment == 0;
+    };
+
+    SnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, snapshotMagic, sizeof(header.magic)) != 0) {
+        return invalid();
+    }
+    if (header.version != snapshotVersion || header.byteOrder != byteOrderMark ||
+        header.offsetSize != sizeof(qsizetype)) {
+        m_snapshotError = QString("Snapshot from another version or platform: %1").arg(path);
+        return false;
+    }
+    const qint64 maxColumns =
+        (size - qint64(sizeof(SnapshotHeader))) / qint64(sizeof(SnapshotColumn));
+    if (header.rows < 0 || header.rows > std::numeric_limits<int>::max() || header.columns < 0 ||
+        header.columns > maxColumns || !fits(header.metaOffset, header.metaSize, 1)) {
+        return invalid();
+    }
+    const int rows = static_cast<int>(header.rows);
+
+    QStringList horizontalLabels;
+    QStringList verticalLabels;
+    QVariantMap meta;
+    {
+        const QByteArray block = QByteArray::fromRawData(
+            reinterpret_cast<const char*>(base + header.metaOffset), header.metaSize);
+        QDataStream stream(block);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream >> horizontalLabels >> verticalLabels >> meta;
+        if (stream.status() != QDataStream::Ok) {
+            return invalid();
+        }
+    }
+
+    QList<TableColumn> columns;
+    QList<ColumnType> types;
+    columns.reserve(header.columns);
+    for (qint64 col = 0; col < header.columns; ++col) {
+        SnapshotColumn entry;
+        std::memcpy(&entry, base + sizeof(SnapshotHeader) + col * sizeof(SnapshotColumn),
+                    sizeof(entry));
+        if (entry.type < qint64(ColumnType::String) || entry.type > qint64(ColumnType::Time)) {
+            return invalid();
+        }
+        const auto type = static_cast<ColumnType>(entry.type);
+        if (type != ColumnType::String) {
+            if (!fits(entry.values, rows * qint64(sizeof(qint64)), alignof(qint64))) {
+                return invalid();
+            }
+            columns.append(TableColumn::fromRawData(
+                type, reinterpret_cast<const qint64*>(base + entry.values), rows, file));
+            types.append(type);
+            continue;
+        }
+        const bool encoded = entry.codes != 0;
+        if (encoded && (entry.entries < 0 || entry.entries > std::numeric_limits<int>::max() ||
+                        !fits(entry.codes, rows * qint64(sizeof(quint32)), alignof(quint32)))) {
+            return invalid();
+        }
+        const qint64 spans = encoded ? entry.entries : rows;
+        if (!fits(entry.chars, entry.charCount * qint64(sizeof(QChar)), alignof(QChar)) ||
+            !fits(entry.starts, spans * qint64(sizeof(qsizetype)), alignof(qsizetype)) ||
+            !fits(entry.lengths, spans * qint64(sizeof(int)), alignof(int))) {
+            return invalid();
+        }
+        const QStringView chars(reinterpret_cast<const QChar*>(base + entry.chars),
+                                entry.charCount);
+        const auto* starts = reinterpret_cast<const qsizetype*>(base + entry.starts);
+        const auto* lengths = reinterpret_cast<const int*>(base + entry.lengths);
+        if (encoded) {
+            columns.append(TableColumn::fromRawData(
+                chars, starts, lengths, static_cast<int>(spans),
+                reinterpret_cast<const quint32*>(base + entry.codes), rows, file));
+        } else {
+            columns.append(TableColumn::fromRawData(chars, starts, lengths, rows, file));
+        }
+        types.append(type);
+    }
+
+    releaseQuery();
+    beginBatch();
+    m_columns = std::move(columns);
+    m_columnTypes = types;
+    m_rowCount = rows;
+    m_horizontalLabels = horizontalLabels;
+    m_verticalLabels = verticalLabels;
+    endBatch();
+
+    if (metadata != nullptr) {
+        *metadata = meta;
+    }
+    return true;
+}
+
+QStringList RowRef::toStringList() const {
+    QStringList cells;
+    cells.reserve(columnCount());
+    QString buffer;
+    for (int column = 0; column < columnCount(); ++column) {
+        cells.append(cell(column, buffer).toString());
+    }
+    return cells;
+}
@@ -0,0 +1,245 @@
+#include "../include/LiteralMatcher.hpp"
+
+#include <QtAlgorithms>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define QT6PLUS_HAVE_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define QT6PLUS_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+namespace {
+
+// Result of a kernel run. nonAscii is only meaningful when the needle was not found.
+struct SearchResult {
+    bool found = false;
+    bool nonAscii = false;
+};
+
+inline char16_t foldAscii(char16_t c) {
+    return (c >= u'A' && c <= u'Z') ? char16_t(c + 32) : c;
+}
+
+// Compares nn units at h against the (already folded) needle.
+inline bool equalsAt(const char16_t* h, const char16_t* n, qsizetype nn, bool fold) {
+    for (qsizetype k = 0; k < nn; ++k) {
+        const char16_t c = fold ? foldAscii(h[k]) : h[k];
+        if (c != n[k]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Scalar search of candidate positions [from, hn - nn], accumulating every unit seen from
+// position `from` to the end of the haystack into seen.
+inline bool scalarTail(const char16_t* h, qsizetype hn, const char16_t* n, qsizetype nn,
+                       bool fold, qsizetype from, char16_t& seen) {
+    const char16_t first = n[0];
+    for (qsizetype i = from; i + nn <= hn; ++i) {
+        const char16_t c = h[i];
+        seen |= c;
+        if ((fold ? foldAscii(c) : c) == first && equalsAt(h + i, n, nn, fold)) {
+            return true;
+        }
+    }
+    for (qsizetype i = qMax(from, hn - nn + 1); i < hn; ++i) {
+        seen |= h[i];
+    }
+    return false;
+}
+
+SearchResult findScalar(const char16_t* h, qsizetype hn, const char16_t* n, qsizetype nn,
+                        bool fold) {
+    char16_t seen = 0;
+    const bool found = scalarTail(h, hn, n, nn, fold, 0, seen);
+    return {found, (seen & 0xFF80) != 0};
+}
+
+#ifdef QT6PLUS_HAVE_SSE2
+inline __m128i foldSse2(__m128i v) {
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi16(v, _mm_set1_epi16('A' - 1)),
+                                        _mm_cmplt_epi16(v, _mm_set1_epi16('Z' + 1)));
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi16(0x20)));
+}
+
+SearchResult findSse2(const char16_t* h, qsizetype hn, const char16_t* n, qsizetype nn,
+                      bool fold) {
+    // Compare the first and last needle characters against 8 positions at once; only
+    // positions where both match are verified in full.
+    const __m128i first = _mm_set1_epi16(short(n[0]));
+    const __m128i last = _mm_set1_epi16(short(n[nn - 1]));
+    __m128i seen = _mm_setzero_si128();
+
+    qsizetype i = 0;
+    for (; i + 8 + nn - 1 <= hn; i += 8) {
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i));
+        const __m128i blockLast =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + nn - 1));
+        seen = _mm_or_si128(seen, blockFirst);
+
+        const __m128i eqFirst =
+            _mm_cmpeq_epi16(fold ? foldSse2(blockFirst) : blockFirst, first);
+        const __m128i eqLast = _mm_cmpeq_epi16(fold ? foldSse2(blockLast) : blockLast, last);
+        auto mask = uint(_mm_movemask_epi8(_mm_and_si128(eqFirst, eqLast)));
+
+        while (mask != 0) {
+            const uint bit = qCountTrailingZeroBits(mask);
+            if (equalsAt(h + i + bit / 2, n, nn, fold)) {
+                return {true, false};
+            }
+            mask &= ~(3U << bit);
+        }
+    }
+
+    alignas(16) char16_t lanes[8];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), seen);
+    char16_t seenUnits = 0;
+    for (char16_t lane : lanes) {
+        seenUnits |= lane;
+    }
+
+    const bool found = scalarTail(h, hn, n, nn, fold, i, seenUnits);
+    return {found, (seenUnits & 0xFF80) != 0};
+}
+#endif
+
+#ifdef QT6PLUS_HAVE_AVX2
+__attribute__((target("avx2"))) inline __m256i foldAvx2(__m256i v) {
+    const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi16(v, _mm256_set1_epi16('A' - 1)),
+                                           _mm256_cmpgt_epi16(_mm256_set1_epi16('Z' + 1), v));
+    return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi16(0x20)));
+}
+
+__attribute__((target("avx2"))) SearchResult findAvx2(const char16_t* h, qsizetype hn,
+                                                      const char16_t* n, qsizetype nn,
+                                                      bool fold) {
+    // Same scheme as findSse2, 16 positions per step.
+    const __m256i first = _mm256_set1_epi16(short(n[0]));
+    const __m256i last = _mm256_set1_epi16(short(n[nn - 1]));
+    __m256i seen = _mm256_setzero_si256();
+
+    qsizetype i = 0;
+    for (; i + 16 + nn - 1 <= hn; i += 16) {
+        const __m256i blockFirst =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i));
+        const __m256i blockLast =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i + nn - 1));
+        seen = _mm256_or_si256(seen, blockFirst);
+
+        const __m256i eqFirst =
+            _mm256_cmpeq_epi16(fold ? foldAvx2(blockFirst) : blockFirst, first);
+        const __m256i eqLast = _mm256_cmpeq_epi16(fold ? foldAvx2(blockLast) : blockLast, last);
+        auto mask = uint(_mm256_movemask_epi8(_mm256_and_si256(eqFirst, eqLast)));
+
+        while (mask != 0) {
+            const uint bit = qCountTrailingZeroBits(mask);
+            if (equalsAt(h + i + bit / 2, n, nn, fold)) {
+                return {true, false};
+            }
+            mask &= ~(3U << bit);
+        }
+    }
+
+    alignas(32) char16_t lanes[16];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), seen);
+    char16_t seenUnits = 0;
+    for (char16_t lane : lanes) {
+        seenUnits |= lane;
+    }
+
+    const bool found = scalarTail(h, hn, n, nn, fold, i, seenUnits);
+    return {found, (seenUnits & 0xFF80) != 0};
+}
+#endif
+
+LiteralMatcher::Kernel bestKernel() {
+#ifdef QT6PLUS_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return LiteralMatcher::Kernel::Avx2;
+    }
+#endif
+#ifdef QT6PLUS_HAVE_SSE2
+    return LiteralMatcher::Kernel::Sse2;
+#else
+    return LiteralMatcher::Kernel::Scalar;
+#endif
+}
+
+}  // namespace
+
+LiteralMatcher::LiteralMatcher(QStringView needle, Qt::CaseSensitivity cs, Kernel kernel)
+    : m_needle(cs == Qt::CaseInsensitive ? needle.toString().toLower() : needle.toString()),
+      m_cs(cs),
+      m_kernel(isSupported(kernel) && kernel != Kernel::Best ? kernel : bestKernel()) {}
+
+bool LiteralMatcher::canMatch(QStringView needle) {
+    if (needle.isEmpty()) {
+        return false;
+    }
+    for (QChar c : needle) {
+        if (c.unicode() >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LiteralMatcher::isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Best:
+        case Kernel::Scalar:
+            return true;
+        case Kernel::Sse2:
+#ifdef QT6PLUS_HAVE_SSE2
+            return true;
+#else
+            return false;
+#endif
+        case Kernel::Avx2:
+#ifdef QT6PLUS_HAVE_AVX2
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+bool LiteralMatcher::contains(QStringView haystack) const {
+    const qsizetype nn = m_needle.size();
+    const qsizetype hn = haystack.size();
+    if (nn > hn) {
+        return false;
+    }
+
+    const auto* h = reinterpret_cast<const char16_t*>(haystack.data());
+    const auto* n = reinterpret_cast<const char16_t*>(m_needle.constData());
+    const bool fold = m_cs == Qt::CaseInsensitive;
+
+    SearchResult result;
+    switch (m_kernel) {
+#ifdef QT6PLUS_HAVE_AVX2
+        case Kernel::Avx2:
+            result = findAvx2(h, hn, n, nn, fold);
+            break;
+#endif
+#ifdef QT6PLUS_HAVE_SSE2
+        case Kernel::Sse2:
+            result = findSse2(h, hn, n, nn, fold);
+            break;
+#endif
+        default:
+            result = findScalar(h, hn, n, nn, fold);
+    }
+
+    if (result.found) {
+        return true;
+    }
+
+    // Non-ASCII text may still match under full Unicode case folding.
+    return fold && result.nonAscii && haystack.contains(m_needle, Qt::CaseInsensitive);
+}
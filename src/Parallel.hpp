@@ -0,0 +1,211 @@
+#ifndef QT6PLUS_PARALLEL_H
+#define QT6PLUS_PARALLEL_H
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+// Internal helpers for splitting work over QThreadPool::globalInstance().
+namespace parallel {
+
+namespace detail {
+
+/**
+ * Runs task(i) for every i in [0, count) on the calling thread plus any idle pool threads,
+ * and returns once all are done. Tasks are handed out in order from a shared counter.
+ */
+template <typename Fn>
+void runTasks(qsizetype count, const Fn& task) {
+    if (count <= 0) {
+        return;
+    }
+    if (count == 1) {
+        task(qsizetype(0));
+        return;
+    }
+
+    QThreadPool* pool = QThreadPool::globalInstance();
+    const qsizetype threads = qMax(1, pool->maxThreadCount());
+
+    std::atomic<qsizetype> next{0};
+    auto work = [&]() {
+        for (;;) {
+            const qsizetype i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count) {
+                return;
+            }
+            task(i);
+        }
+    };
+
+    QSemaphore done;
+    int helpers = 0;
+    for (qsizetype i = 1; i < qMin(threads, count); ++i) {
+        if (!pool->tryStart([&work, &done]() {
+                work();
+                done.release();
+            })) {
+            break;
+        }
+        ++helpers;
+    }
+
+    work();
+    done.acquire(helpers);
+}
+
+}  // namespace detail
+
+/**
+ * Calls fn(begin, end) over consecutive chunks covering [0, count) using the global thread
+ * pool, and returns once every chunk is done. The calling thread works on chunks too, and
+ * helpers are only started if the pool has idle threads, so nested calls from pool threads
+ * cannot deadlock.
+ *
+ * Chunk boundaries are multiples of 64 so chunks never share a word of a RowBitmap.
+ * @param count Number of items.
+ * @param minChunk Smallest chunk worth handing to another thread.
+ * @param fn Callable taking (qsizetype begin, qsizetype end). Must be safe to call
+ * concurrently for disjoint ranges.
+ */
+template <typename Fn>
+void forChunks(qsizetype count, qsizetype minChunk, const Fn& fn) {
+    if (count <= 0) {
+        return;
+    }
+
+    const qsizetype threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+
+    // A few chunks per thread keeps threads busy when chunks take uneven time.
+    qsizetype chunkSize = (count + threads * 4 - 1) / (threads * 4);
+    chunkSize = qMax(chunkSize, qMax<qsizetype>(minChunk, 1));
+    chunkSize = (chunkSize + 63) / 64 * 64;
+    const qsizetype chunks = (count + chunkSize - 1) / chunkSize;
+
+    detail::runTasks(chunks, [&](qsizetype chunk) {
+        const qsizetype begin = chunk * chunkSize;
+        fn(begin, qMin(count, begin + chunkSize));
+    });
+}
+
+/**
+ * Calls fn(i) for every i in [0, count), each as its own task, and returns once all are
+ * done. For a handful of coarse tasks; forChunks() is better for splitting a large range.
+ */
+template <typename Fn>
+void forEach(qsizetype count, const Fn& fn) {
+    detail::runTasks(count, fn);
+}
+
+/**
+ * Stable sort of items in parallel: runs of items are sorted on separate threads, then
+ * merged pairwise, each round of merges in parallel.
+ * @param less Strict weak ordering. Must be safe to call concurrently.
+ */
+template <typename T, typename Less>
+void stableSort(QList<T>& items, const Less& less) {
+    const qsizetype count = items.size();
+    const qsizetype threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const qsizetype runSize = qMax<qsizetype>(4096, (count + threads - 1) / threads);
+    const qsizetype runs = (count + runSize - 1) / runSize;
+
+    // Detach once up front; threads only touch the raw storage.
+    T* data = items.data();
+    detail::runTasks(runs, [&](qsizetype run) {
+        T* begin = data + run * runSize;
+        std::stable_sort(begin, begin + qMin(runSize, count - run * runSize), less);
+    });
+    if (runs <= 1) {
+        return;
+    }
+
+    // std::merge takes from the left range on ties, which keeps the sort stable.
+    QList<T> buffer(count);
+    T* from = data;
+    T* to = buffer.data();
+    for (qsizetype width = runSize; width < count; width *= 2) {
+        const qsizetype pairs = (count + 2 * width - 1) / (2 * width);
+        detail::runTasks(pairs, [&](qsizetype pair) {
+            const qsizetype begin = pair * 2 * width;
+            const qsizetype middle = qMin(count, begin + width);
+            const qsizetype end = qMin(count, begin + 2 * width);
+            std::merge(from + begin, from + middle, from + middle, from + end, to + begin, less);
+        });
+        std::swap(from, to);
+    }
+    if (from != data) {
+        items.swap(buffer);
+    }
+}
+
+// Upper bound on the threads working in parallel, for callers sizing per-thread buffers.
+inline int idealThreadCount() {
+    return qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+}
+
+/**
+ * Tracks background jobs started on the global pool so their owner can stop them.
+ * Each job gets a cancellation flag to poll. cancel() raises the flag of every job started so
+ * far; jobs started afterwards get a fresh one. Owners call cancelAndWait() from their
+ * destructor, before anything a running job posts results to goes away.
+ */
+class TaskGroup {
+   public:
+    TaskGroup() = default;
+    ~TaskGroup() { cancelAndWait(); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // Runs fn(const std::atomic<bool>& cancelled) on the global pool.
+    template <typename Fn>
+    void start(Fn fn) {
+        {
+            QMutexLocker lock(&m_mutex);
+            ++m_running;
+        }
+
+        std::shared_ptr<std::atomic<bool>> token = m_token;
+        QThreadPool::globalInstance()->start([this, token, fn = std::move(fn)]() {
+            fn(*token);
+
+            QMutexLocker lock(&m_mutex);
+            if (--m_running == 0) {
+                m_idle.wakeAll();
+            }
+        });
+    }
+
+    // Asks every job started so far to stop. Does not wait.
+    void cancel() {
+        m_token->store(true);
+        m_token = std::make_shared<std::atomic<bool>>(false);
+    }
+
+    // Blocks until no job is running.
+    void wait() {
+        QMutexLocker lock(&m_mutex);
+        while (m_running > 0) {
+            m_idle.wait(&m_mutex);
+        }
+    }
+
+    void cancelAndWait() {
+        cancel();
+        wait();
+    }
+
+   private:
+    QMutex m_mutex;
+    QWaitCondition m_idle;
+    int m_running = 0;
+    std::shared_ptr<std::atomic<bool>> m_token = std::make_shared<std::atomic<bool>>(false);
+};
+
+}  // namespace parallel
+
+#endif  // QT6PLUS_PARALLEL_H
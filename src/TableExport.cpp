@@ -0,0 +1,471 @@
+#include "../include/TableExport.hpp"
+
+#include <QByteArray>
+#include <QLocale>
+#include <QStringEncoder>
+#include <charconv>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "Parallel.hpp"
+
+// ======================= TableSnapshot =======================
+
+TableSnapshot TableSnapshot::of(const ColumnarTableModel& model) {
+    TableSnapshot snapshot;
+    snapshot.columns = model.columns();
+    snapshot.rows.resize(model.rowCount());
+    std::iota(snapshot.rows.begin(), snapshot.rows.end(), 0);
+    for (int col = 0; col < model.columnCount(); ++col) {
+        snapshot.names.append(model.headerData(col, Qt::Horizontal).toString());
+    }
+    return snapshot;
+}
+
+// ======================= ExportFormatter =======================
+
+void ExportFormatter::prepare(const TableSnapshot& snapshot) {
+    Q_UNUSED(snapshot);
+}
+
+void ExportFormatter::writeHeader(const TableSnapshot& snapshot, QString& out) const {
+    Q_UNUSED(snapshot);
+    Q_UNUSED(out);
+}
+
+void ExportFormatter::writeFooter(const TableSnapshot& snapshot, QString& out) const {
+    Q_UNUSED(snapshot);
+    Q_UNUSED(out);
+}
+
+// ======================= CsvFormatter =======================
+
+CsvFormatter::CsvFormatter(bool headerRow, QString lineEnd)
+    : m_headerRow(headerRow), m_lineEnd(std::move(lineEnd)) {}
+
+void CsvFormatter::appendField(QString& out, QStringView text, bool alwaysQuote) {
+    bool quote = alwaysQuote;
+    for (QChar c : text) {
+        if (c == u',' || c == u'"' || c == u'\r' || c == u'\n') {
+            quote = true;
+            break;
+        }
+    }
+
+    if (!quote) {
+        out.append(text);
+        return;
+    }
+
+    out.append(u'"');
+    qsizetype from = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        if (text[i] == u'"') {
+            out.append(text.mid(from, i - from + 1));
+            out.append(u'"');
+            from = i + 1;
+        }
+    }
+    out.append(text.mid(from));
+    out.append(u'"');
+}
+
+void CsvFormatter::writeHeader(const TableSnapshot& snapshot, QString& out) const {
+    if (!m_headerRow) {
+        return;
+    }
+
+    for (int col = 0; col < snapshot.columnCount(); ++col) {
+        if (col > 0) {
+            out.append(u',');
+        }
+        appendField(out, snapshot.names.value(col));
+    }
+    out.append(m_lineEnd);
+}
+
+void CsvFormatter::writeRow(const TableSnapshot& snapshot, int index, QString& out) const {
+    QString buffer;
+    for (int col = 0; col < snapshot.columnCount(); ++col) {
+        if (col > 0) {
+            out.append(u',');
+        }
+        appendField(out, snapshot.cell(index, col, buffer));
+    }
+    out.append(m_lineEnd);
+}
+
+// ======================= JsonFormatter =======================
+
+namespace {
+
+// JSON value type a column is written as by default, after its storage.
+JsonValueType jsonTypeOf(ColumnType type) {
+    switch (type) {
+        case ColumnType::Int64:
+            return JsonValueType::Integer;
+        case ColumnType::Double:
+            return JsonValueType::Double;
+        case ColumnType::Bool:
+            return JsonValueType::Bool;
+        default:
+            return JsonValueType::String;
+    }
+}
+
+void appendInteger(QString& out, qint64 value) {
+    char digits[24];
+    const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+    out.append(QLatin1String(digits, result.ptr - digits));
+}
+
+// Appends a cell of a typed column straight from its value, when that value already is a
+// JSON value of type. False if the cell has to go through its text instead.
+bool appendNative(QString& out, const TableColumn& column, int row, JsonValueType type) {
+    const ColumnType storage = column.type();
+    const bool native = (storage == ColumnType::Int64 && type != JsonValueType::String &&
+                         type != JsonValueType::Bool) ||
+                        (storage == ColumnType::Double && type == JsonValueType::Double) ||
+                        (storage == ColumnType::Bool && type == JsonValueType::Bool);
+    if (!native) {
+        return false;
+    }
+
+    if (column.isNull(row)) {
+        out.append(QLatin1String("null"));
+    } else if (storage == ColumnType::Int64) {
+        appendInteger(out, column.integer(row));
+    } else if (storage == ColumnType::Bool) {
+        out.append(column.integer(row) != 0 ? QLatin1String("true") : QLatin1String("false"));
+    } else if (!std::isfinite(column.number(row))) {
+        out.append(QLatin1String("null"));
+    } else {
+        out.append(QString::number(column.number(row), 'g', QLocale::FloatingPointShortest));
+    }
+    return true;
+}
+
+}  // namespace
+
+JsonFormatter::JsonFormatter(JsonExportOptions options) : m_options(std::move(options)) {}
+
+void JsonFormatter::appendString(QString& out, QStringView text) {
+    static constexpr char hex[] = "0123456789abcdef";
+
+    out.append(u'"');
+    qsizetype from = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const char16_t c = text[i].unicode();
+        if (c >= 0x20 && c != u'"' && c != u'\\') {
+            continue;
+        }
+
+        out.append(text.mid(from, i - from));
+        from = i + 1;
+        switch (c) {
+            case u'"':
+                out.append(u"\\\"");
+                break;
+            case u'\\':
+                out.append(u"\\\\");
+                break;
+            case u'\n':
+                out.append(u"\\n");
+                break;
+            case u'\r':
+                out.append(u"\\r");
+                break;
+            case u'\t':
+                out.append(u"\\t");
+                break;
+            default:
+                out.append(u"\\u00");
+                out.append(QChar(hex[c >> 4]));
+                out.append(QChar(hex[c & 0xF]));
+        }
+    }
+    out.append(text.mid(from));
+    out.append(u'"');
+}
+
+void JsonFormatter::prepare(const TableSnapshot& snapshot) {
+    m_keys.clear();
+    m_types.clear();
+    for (int col = 0; col < snapshot.columnCount(); ++col) {
+        QString key(QChar(col == 0 ? u'{' : u','));
+        appendString(key, snapshot.names.value(col));
+        key.append(u':');
+        m_keys.append(key);
+        m_types.append(
+            m_options.columnTypes.value(col, jsonTypeOf(snapshot.columns[col].type())));
+    }
+}
+
+void JsonFormatter::writeHeader(const TableSnapshot& snapshot, QString& out) const {
+    Q_UNUSED(snapshot);
+    if (m_options.layout == JsonLayout::Array) {
+        out.append(u'[');
+    }
+}
+
+void JsonFormatter::writeRow(const TableSnapshot& snapshot, int index, QString& out) const {
+    if (m_options.layout == JsonLayout::Array) {
+        out.append(index > 0 ? QStringView(u",\n") : QStringView(u"\n"));
+    }
+
+    if (snapshot.columnCount() == 0) {
+        out.append(u"{}");
+    }
+    QString buffer;
+    for (int col = 0; col < snapshot.columnCount(); ++col) {
+        out.append(m_keys[col]);
+        if (!appendNative(out, snapshot.columns[col], snapshot.rows[index], m_types[col])) {
+            appendValue(out, snapshot.cell(index, col, buffer), m_types[col]);
+        }
+    }
+    if (snapshot.columnCount() > 0) {
+        out.append(u'}');
+    }
+
+    if (m_options.layout == JsonLayout::Lines) {
+        out.append(u'\n');
+    }
+}
+
+void JsonFormatter::writeFooter(const TableSnapshot& snapshot, QString& out) const {
+    if (m_options.layout == JsonLayout::Array) {
+        out.append(snapshot.rowCount() > 0 ? QStringView(u"\n]\n") : QStringView(u"]\n"));
+    }
+}
+
+void JsonFormatter::appendValue(QString& out, QStringView text, JsonValueType type) const {
+    static const QLatin1String null("null");
+
+    switch (type) {
+        case JsonValueType::String:
+            if (text.isEmpty() && m_options.emptyAsNull) {
+                out.append(null);
+            } else {
+                appendString(out, text);
+            }
+            return;
+
+        case JsonValueType::Integer: {
+            bool ok = false;
+            const qlonglong value = text.trimmed().toLongLong(&ok);
+            if (!ok) {
+                out.append(null);
+                return;
+            }
+            // Formatted on the stack; also normalises forms JSON rejects, like "+7" or "007".
+            appendInteger(out, value);
+            return;
+        }
+
+        case JsonValueType::Double: {
+            bool ok = false;
+            const double value = text.trimmed().toDouble(&ok);
+            if (!ok || !std::isfinite(value)) {
+                out.append(null);
+                return;
+            }
+            out.append(QString::number(value, 'g', QLocale::FloatingPointShortest));
+            return;
+        }
+
+        case JsonValueType::Bool: {
+            const QStringView value = text.trimmed();
+            auto is = [value](const char* word) {
+                return value.compare(QLatin1String(word), Qt::CaseInsensitive) == 0;
+            };
+            if (is("true") || is("1") || is("yes") || is("on")) {
+                out.append(QLatin1String("true"));
+            } else if (is("false") || is("0") || is("no") || is("off")) {
+                out.append(QLatin1String("false"));
+            } else {
+                out.append(null);
+            }
+            return;
+        }
+    }
+}
+
+// ======================= HtmlFormatter =======================
+
+void HtmlFormatter::appendEscaped(QString& out, QStringView text) {
+    qsizetype from = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const char16_t c = text[i].unicode();
+        if (c != u'<' && c != u'>' && c != u'&' && c != u'"') {
+            continue;
+        }
+
+        out.append(text.mid(from, i - from));
+        from = i + 1;
+        switch (c) {
+            case u'<':
+                out.append(QLatin1String("&lt;"));
+                break;
+            case u'>':
+                out.append(QLatin1String("&gt;"));
+                break;
+            case u'&':
+                out.append(QLatin1String("&amp;"));
+                break;
+            default:
+                out.append(QLatin1String("&quot;"));
+        }
+    }
+    out.append(text.mid(from));
+}
+
+void HtmlFormatter::writeHeader(const TableSnapshot& snapshot, QString& out) const {
+    out.append(QLatin1String("<table style='border-collapse: collapse; width: 100%;'>"));
+    out.append(QLatin1String("<thead><tr>"));
+    for (int col = 0; col < snapshot.columnCount(); ++col) {
+        out.append(QLatin1String(
+            "<th style='border: 1px solid #ddd; padding: 8px; background-color: #f2f2f2;'>"));
+        appendEscaped(out, snapshot.names.value(col));
+        out.append(QLatin1String("</th>"));
+    }
+    out.append(QLatin1String("</tr></thead><tbody>"));
+}
+
+void HtmlFormatter::writeRow(const TableSnapshot& snapshot, int index, QString& out) const {
+    QString buffer;
+    out.append(QLatin1String("<tr>"));
+    for (int col = 0; col < snapshot.columnCount(); ++col) {
+        out.append(QLatin1String("<td style='border: 1px solid #ddd; padding: 8px;'>"));
+        appendEscaped(out, snapshot.cell(index, col, buffer));
+        out.append(QLatin1String("</td>"));
+    }
+    out.append(QLatin1String("</tr>"));
+}
+
+void HtmlFormatter::writeFooter(const TableSnapshot& snapshot, QString& out) const {
+    Q_UNUSED(snapshot);
+    out.append(QLatin1String("</tbody></table>"));
+}
+
+// ======================= TableExporter =======================
+
+namespace {
+
+// Formatted text of a run of rows, and its UTF-8 encoding when writing to a device.
+struct ExportChunk {
+    QString text;
+    QByteArray bytes;
+
+    void encode() {
+        // Chunks hold whole rows, so every chunk encodes independently.
+        QStringEncoder encoder(QStringEncoder::Utf8);
+        bytes.resize(encoder.requiredSpace(text.size()));
+        const char* end = encoder.appendToBuffer(bytes.data(), text);
+        bytes.resize(end - bytes.constData());
+    }
+};
+
+}  // namespace
+
+void TableExporter::setChunkRows(int rows) {
+    m_chunkRows = qMax(1, rows);
+}
+
+bool TableExporter::run(const TableSnapshot& snapshot, ExportFormatter& formatter, bool encode,
+                        const std::atomic<bool>* cancelled,
+                        const std::function<bool(const QString&, const QByteArray&)>& sink,
+                        const Progress& progress) {
+    m_error.clear();
+    formatter.prepare(snapshot);
+
+    ExportChunk edge;
+    formatter.writeHeader(snapshot, edge.text);
+    if (encode) {
+        edge.encode();
+    }
+    if (!sink(edge.text, edge.bytes)) {
+        return false;
+    }
+
+    // Chunks are formatted a window at a time, then written in order. The window's buffers
+    // are reused, so memory is bounded by the window size rather than the row count.
+    const int rows = snapshot.rowCount();
+    const qsizetype chunks = (qsizetype(rows) + m_chunkRows - 1) / m_chunkRows;
+    const qsizetype window = 2 * qsizetype(parallel::idealThreadCount());
+    std::vector<ExportChunk> buffers(qMin(window, qMax<qsizetype>(chunks, 1)));
+
+    for (qsizetype first = 0; first < chunks; first += window) {
+        if (cancelled != nullptr && cancelled->load()) {
+            m_error = QStringLiteral("Export cancelled");
+            return false;
+        }
+
+        const qsizetype count = qMin(window, chunks - first);
+        parallel::forEach(count, [&](qsizetype i) {
+            ExportChunk& chunk = buffers[i];
+            chunk.text.resize(0);
+            const int begin = int((first + i) * m_chunkRows);
+            const int end = qMin(rows, begin + m_chunkRows);
+            for (int index = begin; index < end; ++index) {
+                formatter.writeRow(snapshot, index, chunk.text);
+            }
+            if (encode) {
+                chunk.encode();
+            }
+        });
+
+        for (qsizetype i = 0; i < count; ++i) {
+            if (!sink(buffers[i].text, buffers[i].bytes)) {
+                return false;
+            }
+        }
+        if (progress) {
+            progress(qMin<qint64>(rows, qint64(first + count) * m_chunkRows));
+        }
+    }
+
+    edge.text.resize(0);
+    formatter.writeFooter(snapshot, edge.text);
+    if (encode) {
+        edge.encode();
+    }
+    if (!sink(edge.text, edge.bytes)) {
+        return false;
+    }
+    if (progress && rows == 0) {
+        progress(0);
+    }
+    return true;
+}
+
+bool TableExporter::write(const TableSnapshot& snapshot, ExportFormatter& formatter,
+                          QIODevice* device, const std::atomic<bool>* cancelled,
+                          const Progress& progress) {
+    if (device == nullptr || !device->isWritable()) {
+        m_error = QStringLiteral("Device is not open for writing");
+        return false;
+    }
+
+    return run(
+        snapshot, formatter, true, cancelled,
+        [this, device](const QString&, const QByteArray& bytes) {
+            if (device->write(bytes) != bytes.size()) {
+                m_error = device->errorString();
+                return false;
+            }
+            return true;
+        },
+        progress);
+}
+
+QString TableExporter::format(const TableSnapshot& snapshot, ExportFormatter& formatter) {
+    QString result;
+    run(snapshot, formatter, false, nullptr, [&result](const QString& text, const QByteArray&) {
+        result.append(text);
+        return true;
+    });
+    return result;
+}
@@ -0,0 +1,1234 @@
+#include "../include/TableFilter.hpp"
+
+#include <QtAlgorithms>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <utility>
+
+#include "Parallel.hpp"
+
+// ======================= RowBitmap =======================
+
+void RowBitmap::resize(int size) {
+    m_words.resize((size + 63) / 64);
+    m_size = size;
+
+    // Keep the bits past the end cleared so count() and later growth stay correct.
+    if ((size & 63) != 0) {
+        m_words.last() &= (quint64(1) << (size & 63)) - 1;
+    }
+}
+
+void RowBitmap::insert(int row, int count) {
+    const int oldSize = m_size;
+    resize(m_size + count);
+    for (int i = oldSize - 1; i >= row; --i) {
+        set(i + count, test(i));
+    }
+    for (int i = row; i < row + count; ++i) {
+        set(i, false);
+    }
+}
+
+void RowBitmap::remove(int row, int count) {
+    for (int i = row + count; i < m_size; ++i) {
+        set(i - count, test(i));
+    }
+    resize(m_size - count);
+}
+
+int RowBitmap::count() const {
+    int total = 0;
+    for (quint64 word : m_words) {
+        total += qPopulationCount(word);
+    }
+    return total;
+}
+
+void RowBitmap::permute(const QList<int>& order) {
+    RowBitmap permuted(int(order.size()));
+
+    // Chunks cover whole words of the new bitmap, so threads never share one.
+    parallel::forChunks(order.size(), 16384, [&](qsizetype begin, qsizetype end) {
+        for (qsizetype i = begin; i < end; ++i) {
+            if (test(order[i])) {
+                permuted.set(int(i));
+            }
+        }
+    });
+    *this = std::move(permuted);
+}
+
+// ======================= RowMatcher =======================
+
+namespace {
+
+// Index of the ']' closing the character class opened at start, or the pattern size.
+qsizetype skipCharacterClass(const QString& pattern, qsizetype start) {
+    qsizetype i = start + 1;
+    if (i < pattern.size() && pattern[i] == '^') {
+        ++i;
+    }
+    if (i < pattern.size() && pattern[i] == ']') {
+        ++i;  // A leading ']' is a literal member
+    }
+    for (; i < pattern.size(); ++i) {
+        if (pattern[i] == '\\') {
+            ++i;
+        } else if (pattern[i] == ']') {
+            return i;
+        }
+    }
+    return pattern.size();
+}
+
+// Literal runs outside groups that every match of pattern must contain. Conservative: any
+// construct that could make a character optional ends the run and drops that character.
+QStringList requiredLiteralsOf(const QString& pattern, QRegularExpression::PatternOptions options) {
+    if (options.testFlag(QRegularExpression::ExtendedPatternSyntaxOption) ||
+        pattern.contains('|') || pattern.contains(QLatin1String("(?"))) {
+        return {};
+    }
+
+    QStringList literals;
+    QString run;
+    int depth = 0;
+
+    auto flush = [&]() {
+        if (!run.isEmpty()) {
+            literals.append(run);
+            run.clear();
+        }
+    };
+
+    for (qsizetype i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern[i];
+
+        if (c == '\\' && i + 1 < pattern.size()) {
+            const QChar escaped = pattern[++i];
+            if (escaped.isLetterOrNumber()) {
+                flush();  // \d, \w, \b, back-references, ...
+            } else if (depth == 0) {
+                run.append(escaped);
+            }
+            continue;
+        }
+
+        switch (c.unicode()) {
+            case '(':
+                flush();
+                ++depth;
+                break;
+            case ')':
+                flush();
+                depth = qMax(0, depth - 1);
+                break;
+            case '[':
+                flush();
+                i = skipCharacterClass(pattern, i);
+                break;
+            case '?':
+            case '*':
+            case '{':
+                // The previous character may be absent
+                run.chop(1);
+                flush();
+                if (c == '{') {
+                    while (i < pattern.size() && pattern[i] != '}') {
+                        ++i;
+                    }
+                }
+                break;
+            case '+':
+            case '.':
+            case '^':
+            case '$':
+                flush();
+                break;
+            default:
+                if (depth == 0) {
+                    run.append(c);
+                }
+        }
+    }
+    flush();
+    return literals;
+}
+
+}  // namespace
+
+RowMatcher::RowMatcher(const QRegularExpression& regex, int column)
+    : m_regex(regex), m_column(column) {
+    // Compile once here rather than racing to do it on first use from every worker.
+    m_regex.optimize();
+
+    static const QRegularExpression syntax(QStringLiteral(R"([\\^$.|?*+()\[\]{}])"));
+    const QString pattern = m_regex.pattern();
+    const QRegularExpression::PatternOptions options = m_regex.patternOptions();
+
+    // Extended syntax ignores whitespace, so even a pattern without metacharacters
+    // isn't matched literally.
+    if (!options.testFlag(QRegularExpression::ExtendedPatternSyntaxOption) &&
+        !pattern.contains(syntax)) {
+        m_literal = pattern;
+        m_requiredLiterals = {pattern};
+
+        // Plain ASCII literals skip PCRE entirely
+        if (LiteralMatcher::canMatch(pattern)) {
+            m_fastMatcher.emplace(pattern,
+                                  options.testFlag(QRegularExpression::CaseInsensitiveOption)
+                                      ? Qt::CaseInsensitive
+                                      : Qt::CaseSensitive);
+        }
+    } else {
+        m_requiredLiterals = requiredLiteralsOf(pattern, options);
+    }
+}
+
+bool RowMatcher::narrows(const RowMatcher& previous) const {
+    if (!isLiteral() || !previous.isLiteral() || m_column != previous.m_column ||
+        m_regex.patternOptions() != previous.m_regex.patternOptions()) {
+        return false;
+    }
+
+    const Qt::CaseSensitivity cs =
+        m_regex.patternOptions().testFlag(QRegularExpression::CaseInsensitiveOption)
+            ? Qt::CaseInsensitive
+            : Qt::CaseSensitive;
+    return m_literal.contains(previous.m_literal, cs);
+}
+
+bool RowMatcher::matches(QStringView text) const {
+    if (m_fastMatcher) {
+        return m_fastMatcher->contains(text);
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+    return m_regex.matchView(text).hasMatch();
+#else
+    return m_regex.match(text).hasMatch();
+#endif
+}
+
+bool RowMatcher::matchesRow(const QList<TableColumn>& columns, int row) const {
+    // Typed cells are matched against their displayed text.
+    QString buffer;
+    if (m_column >= 0) {
+        return m_column < columns.size() && matches(columns[m_column].text(row, buffer));
+    }
+
+    for (const TableColumn& column : columns) {
+        if (matches(column.text(row, buffer))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RowMatcher::CodeMatches RowMatcher::matchCodes(const QList<TableColumn>& columns,
+                                               qsizetype rows) const {
+    CodeMatches codes(columns.size());
+    for (qsizetype col = 0; col < columns.size(); ++col) {
+        const TableColumn& column = columns[col];
+        if ((m_column >= 0 && col != m_column) || !column.isEncoded() ||
+            column.dictionarySize() >= rows) {
+            continue;
+        }
+        codes[col].resize(column.dictionarySize());
+        parallel::forChunks(column.dictionarySize(), 256, [&](qsizetype begin, qsizetype end) {
+            for (qsizetype code = begin; code < end; ++code) {
+                codes[col][code] = matches(column.entry(code)) ? 1 : 0;
+            }
+        });
+    }
+    return codes;
+}
+
+bool RowMatcher::matchesRow(const QList<TableColumn>& columns, int row, const CodeMatches& codes,
+                            QString& buffer) const {
+    auto test = [&](qsizetype col) {
+        const TableColumn& column = columns[col];
+        return !codes[col].empty() ? codes[col][column.code(row)] != 0
+                                   : matches(column.text(row, buffer));
+    };
+
+    if (m_column >= 0) {
+        return m_column < columns.size() && test(m_column);
+    }
+    for (qsizetype col = 0; col < columns.size(); ++col) {
+        if (test(col)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RowMatcher::evaluate(const QList<TableColumn>& columns, int first, int count,
+                          RowBitmap& bitmap, const std::atomic<bool>* cancelled) const {
+    // Chunks are aligned to absolute rows so no two threads write the same bitmap word.
+    const int base = first & ~63;
+    const int end = first + count;
+    const CodeMatches codes = matchCodes(columns, count);
+    bitmap.detach();
+
+    parallel::forChunks(end - base, 1024, [&](qsizetype begin, qsizetype stop) {
+        QString buffer;
+        for (int row = qMax(first, base + int(begin)); row < base + int(stop); ++row) {
+            if ((row & 1023) == 0 && cancelled != nullptr && cancelled->load()) {
+                return;
+            }
+            bitmap.set(row, matchesRow(columns, row, codes, buffer));
+        }
+    });
+}
+
+void RowMatcher::refine(const QList<TableColumn>& columns, RowBitmap& bitmap,
+                        const std::atomic<bool>* cancelled) const {
+    const CodeMatches codes = matchCodes(columns, bitmap.count());
+    bitmap.detach();
+
+    parallel::forChunks(bitmap.size(), 4096, [&](qsizetype begin, qsizetype stop) {
+        QString buffer;
+        for (int row = int(begin); row < int(stop);) {
+            // Chunks start on word boundaries, so whole empty words can be skipped.
+            if ((row & 63) == 0) {
+                if (bitmap.wordAt(row) == 0) {
+                    row += 64;
+                    continue;
+                }
+                if ((row & 1023) == 0 && cancelled != nullptr && cancelled->load()) {
+                    return;
+                }
+            }
+            if (bitmap.test(row) && !matchesRow(columns, row, codes, buffer)) {
+                bitmap.set(row, false);
+            }
+            ++row;
+        }
+    });
+}
+
+// ======================= RowOrderProxyModel =======================
+
+namespace {
+
+// Most rows changed at once that are placed by key; more are left to a background resort, as
+// comparing cells one pair at a time only pays for a few rows.
+constexpr int maxPlacedRows = 4096;
+
+/**
+ * order with rows taken out and put back among its first placed rows, which must be in key
+ * order, by binary search with comparer. placed is updated to the rows now in key order.
+ */
+QList<int> placeByKey(const RowSorter& comparer, const QList<TableColumn>& columns,
+                      const QList<int>& order, int& placed, QList<int> rows) {
+    // 1 marks a row to place, 2 one already queued, so repeated rows are placed once.
+    QList<char> moving(order.size(), 0);
+    for (const int row : std::as_const(rows)) {
+        moving[row] = 1;
+    }
+    rows.clear();
+
+    QList<int> kept;
+    QList<int> waiting;
+    kept.reserve(order.size());
+    for (qsizetype position = 0; position < order.size(); ++position) {
+        const int row = order[position];
+        if (moving[row] == 1) {
+            moving[row] = 2;
+            rows.append(row);
+        } else if (moving[row] == 0) {
+            (position < placed ? kept : waiting).append(row);
+        }
+    }
+
+    auto less = [&](int a, int b) { return comparer.compareRows(columns, a, b) < 0; };
+    std::sort(rows.begin(), rows.end(), [&](int a, int b) {
+        const int result = comparer.compareRows(columns, a, b);
+        return result != 0 ? result < 0 : a < b;
+    });
+
+    // The rows to place are sorted, so each search starts where the previous one ended and
+    // the result is spliced together in one pass.
+    QList<int> result;
+    result.reserve(order.size());
+    auto next = kept.cbegin();
+    for (const int row : std::as_const(rows)) {
+        const auto at = std::upper_bound(next, kept.cend(), row, less);
+        std::copy(next, at, std::back_inserter(result));
+        result.append(row);
+        next = at;
+    }
+    std::copy(next, kept.cend(), std::back_inserter(result));
+    placed = int(result.size());
+    result.append(waiting);
+    return result;
+}
+
+}  // namespace
+
+RowOrderProxyModel::RowOrderProxyModel(QObject* parent) : QAbstractProxyModel(parent) {}
+
+void RowOrderProxyModel::setSourceModel(QAbstractItemModel* sourceModel) {
+    beginResetModel();
+    for (const QMetaObject::Connection& connection : m_sourceConnections) {
+        disconnect(connection);
+    }
+    m_sourceConnections.clear();
+
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    m_source = qobject_cast<ColumnarTableModel*>(sourceModel);
+    m_comparer.reset();
+    m_sourceOf.resize(m_source != nullptr ? m_source->rowCount() : 0);
+    std::iota(m_sourceOf.begin(), m_sourceOf.end(), 0);
+    updateRowOf();
+
+    if (m_source != nullptr) {
+        m_sourceConnections = {
+            connect(m_source, &QAbstractItemModel::modelAboutToBeReset, this,
+                    [this]() { beginResetModel(); }),
+            connect(m_source, &QAbstractItemModel::modelReset, this,
+                    [this]() {
+                        // The order described the old rows.
+                        m_comparer.reset();
+                        m_sourceOf.resize(m_source->rowCount());
+                        std::iota(m_sourceOf.begin(), m_sourceOf.end(), 0);
+                        updateRowOf();
+                        endResetModel();
+                    }),
+            connect(m_source, &QAbstractItemModel::columnsAboutToBeInserted, this,
+                    [this](const QModelIndex&, int first, int last) {
+                        beginInsertColumns(QModelIndex(), first, last);
+                    }),
+            connect(m_source, &QAbstractItemModel::columnsInserted, this,
+                    [this]() { endInsertColumns(); }),
+            connect(m_source, &QAbstractItemModel::columnsAboutToBeRemoved, this,
+                    [this](const QModelIndex&, int first, int last) {
+                        beginRemoveColumns(QModelIndex(), first, last);
+                    }),
+            connect(m_source, &QAbstractItemModel::columnsRemoved, this,
+                    [this]() { endRemoveColumns(); }),
+            connect(m_source, &QAbstractItemModel::rowsInserted, this,
+                    [this](const QModelIndex&, int first, int last) {
+                        sourceRowsInserted(first, last);
+                    }),
+            connect(m_source, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+                    [this](const QModelIndex&, int first, int last) {
+                        sourceRowsAboutToBeRemoved(first, last);
+                    }),
+            connect(m_source, &QAbstractItemModel::rowsRemoved, this,
+                    [this](const QModelIndex&, int first, int last) {
+                        sourceRowsRemoved(first, last);
+                    }),
+            connect(m_source, &ColumnarTableModel::rowsPermuted, this,
+                    &RowOrderProxyModel::sourceRowsPermuted),
+            connect(m_source, &QAbstractItemModel::dataChanged, this,
+                    &RowOrderProxyModel::sourceDataChanged),
+            connect(m_source, &QAbstractItemModel::headerDataChanged, this,
+                    [this](Qt::Orientation orientation, int first, int last) {
+                        if (orientation == Qt::Vertical && hasOrder()) {
+                            first = 0;
+                            last = rowCount() - 1;
+                        }
+                        emit headerDataChanged(orientation, first, last);
+                    }),
+        };
+    }
+    endResetModel();
+}
+
+void RowOrderProxyModel::setOrder(const QList<int>& order, RowSorter comparer,
+                                  const QList<int>& changedRows) {
+    if (m_source == nullptr) {
+        return;
+    }
+
+    // 1 marks rows taken from order, 2 rows to place by key.
+    const int rows = int(m_sourceOf.size());
+    QList<char> state(rows, 0);
+    for (const int row : changedRows) {
+        if (row < rows) {
+            state[row] = 2;
+        }
+    }
+    QList<int> sourceOf;
+    sourceOf.reserve(rows);
+    for (const int row : order) {
+        if (row < rows && state[row] == 0) {
+            state[row] = 1;
+            sourceOf.append(row);
+        }
+    }
+    QList<int> unplaced;
+    for (int row = 0; row < rows; ++row) {
+        if (state[row] != 1) {
+            unplaced.append(row);
+        }
+    }
+
+    int placed = int(sourceOf.size());
+    sourceOf.append(unplaced);
+    m_comparer = std::move(comparer);
+    if (unplaced.size() <= maxPlacedRows) {
+        sourceOf = placeByKey(*m_comparer, m_source->columns(), sourceOf, placed, unplaced);
+    }
+    applyOrder(std::move(sourceOf), placed);
+    if (placed < rows) {
+        emit resortNeeded();
+    }
+}
+
+void RowOrderProxyModel::clearOrder() {
+    if (!m_comparer) {
+        return;
+    }
+
+    m_comparer.reset();
+    const int rows = int(m_sourceOf.size());
+    QList<int> sourceOf(rows);
+    std::iota(sourceOf.begin(), sourceOf.end(), 0);
+    applyOrder(std::move(sourceOf), rows);
+}
+
+QModelIndex RowOrderProxyModel::index(int row, int column, const QModelIndex& parent) const {
+    if (parent.isValid() || row < 0 || column < 0 || row >= rowCount() ||
+        column >= columnCount()) {
+        return {};
+    }
+    return createIndex(row, column);
+}
+
+QModelIndex RowOrderProxyModel::parent(const QModelIndex&) const {
+    return {};
+}
+
+int RowOrderProxyModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : int(m_sourceOf.size());
+}
+
+int RowOrderProxyModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() || m_source == nullptr ? 0 : m_source->columnCount();
+}
+
+QModelIndex RowOrderProxyModel::mapToSource(const QModelIndex& proxyIndex) const {
+    const int row = proxyIndex.isValid() ? sourceRow(proxyIndex.row()) : -1;
+    return row < 0 ? QModelIndex() : m_source->index(row, proxyIndex.column());
+}
+
+QModelIndex RowOrderProxyModel::mapFromSource(const QModelIndex& sourceIndex) const {
+    if (!sourceIndex.isValid() || sourceIndex.model() != m_source ||
+        sourceIndex.row() >= m_rowOf.size()) {
+        return {};
+    }
+    return createIndex(m_rowOf[sourceIndex.row()], sourceIndex.column());
+}
+
+QVariant RowOrderProxyModel::headerData(int section, Qt::Orientation orientation,
+                                        int role) const {
+    if (m_source == nullptr) {
+        return {};
+    }
+    // The base class maps sections through index(), which fails while there are no rows.
+    if (orientation == Qt::Vertical) {
+        section = sourceRow(section);
+    }
+    return m_source->headerData(section, orientation, role);
+}
+
+void RowOrderProxyModel::applyOrder(QList<int> sourceOf, int placedRows) {
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    const QList<int> previous = std::exchange(m_sourceOf, std::move(sourceOf));
+    m_placedRows = placedRows;
+    updateRowOf();
+
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex& index : from) {
+        to.append(createIndex(m_rowOf[previous[index.row()]], index.column()));
+    }
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void RowOrderProxyModel::placeRows(const QList<int>& rows) {
+    if (rows.isEmpty()) {
+        return;
+    }
+    if (rows.size() > maxPlacedRows) {
+        emit resortNeeded();
+        return;
+    }
+
+    int placed = m_placedRows;
+    QList<int> sourceOf = placeByKey(*m_comparer, m_source->columns(), m_sourceOf, placed, rows);
+    applyOrder(std::move(sourceOf), placed);
+}
+
+void RowOrderProxyModel::updateRowOf() {
+    m_rowOf.resize(m_sourceOf.size());
+    for (qsizetype row = 0; row < m_sourceOf.size(); ++row) {
+        m_rowOf[m_sourceOf[row]] = int(row);
+    }
+}
+
+void RowOrderProxyModel::sourceRowsInserted(int first, int last) {
+    const int count = last - first + 1;
+    for (int& row : m_sourceOf) {
+        if (row >= first) {
+            row += count;
+        }
+    }
+
+    // Ordered rows arrive at the end and are then moved into place.
+    const int at = hasOrder() ? int(m_sourceOf.size()) : first;
+    beginInsertRows(QModelIndex(), at, at + count - 1);
+    m_sourceOf.insert(at, count, 0);
+    std::iota(m_sourceOf.begin() + at, m_sourceOf.begin() + at + count, first);
+    updateRowOf();
+    endInsertRows();
+
+    if (hasOrder()) {
+        placeRows(m_sourceOf.mid(at));
+    }
+}
+
+void RowOrderProxyModel::sourceRowsAboutToBeRemoved(int first, int last) {
+    const int count = last - first + 1;
+    int low = int(m_sourceOf.size());
+    int high = -1;
+    for (int row = first; row <= last; ++row) {
+        low = qMin(low, m_rowOf[row]);
+        high = qMax(high, m_rowOf[row]);
+    }
+
+    if (high - low + 1 == count) {
+        m_placedRows -= qMax(0, qMin(high + 1, m_placedRows) - low);
+    } else {
+        // Gather the scattered rows at the end so they go in a single removal.
+        QList<int> sourceOf;
+        QList<int> leaving;
+        sourceOf.reserve(m_sourceOf.size());
+        int placed = m_placedRows;
+        for (qsizetype position = 0; position < m_sourceOf.size(); ++position) {
+            const int row = m_sourceOf[position];
+            if (row >= first && row <= last) {
+                leaving.append(row);
+                placed -= position < m_placedRows ? 1 : 0;
+            } else {
+                sourceOf.append(row);
+            }
+        }
+        low = int(sourceOf.size());
+        sourceOf.append(leaving);
+        applyOrder(std::move(sourceOf), placed);
+    }
+
+    m_removedFirst = low;
+    beginRemoveRows(QModelIndex(), low, low + count - 1);
+}
+
+void RowOrderProxyModel::sourceRowsRemoved(int first, int last) {
+    const int count = last - first + 1;
+    m_sourceOf.remove(m_removedFirst, count);
+    for (int& row : m_sourceOf) {
+        if (row > last) {
+            row -= count;
+        }
+    }
+    updateRowOf();
+    endRemoveRows();
+}
+
+void RowOrderProxyModel::sourceRowsPermuted(const QList<int>& order) {
+    if (order.size() != m_sourceOf.size()) {
+        return;
+    }
+
+    // Every row keeps its place in the order; only the source rows are renumbered.
+    QList<int> newRow(order.size());
+    for (qsizetype row = 0; row < order.size(); ++row) {
+        newRow[order[row]] = int(row);
+    }
+    for (int& row : m_sourceOf) {
+        row = newRow[row];
+    }
+    updateRowOf();
+
+    // Without an order the rows follow the source.
+    if (!hasOrder()) {
+        const int rows = int(m_sourceOf.size());
+        QList<int> sourceOf(rows);
+        std::iota(sourceOf.begin(), sourceOf.end(), 0);
+        applyOrder(std::move(sourceOf), rows);
+    }
+}
+
+void RowOrderProxyModel::sourceDataChanged(const QModelIndex& topLeft,
+                                           const QModelIndex& bottomRight,
+                                           const QList<int>& roles) {
+    const int first = topLeft.row();
+    const int last = bottomRight.row();
+    const int left = topLeft.column();
+    const int right = bottomRight.column();
+    if (!hasOrder()) {
+        emit dataChanged(index(first, left), index(last, right), roles);
+        return;
+    }
+
+    // Report the changed rows by runs of adjacent rows, or all at once when there are many.
+    const int count = last - first + 1;
+    if (count > maxPlacedRows) {
+        emit dataChanged(index(0, left), index(rowCount() - 1, right), roles);
+    } else {
+        QList<int> rows;
+        rows.reserve(count);
+        for (int row = first; row <= last; ++row) {
+            rows.append(m_rowOf[row]);
+        }
+        std::sort(rows.begin(), rows.end());
+        for (qsizetype begin = 0, end = 1; begin < rows.size(); begin = end++) {
+            while (end < rows.size() && rows[end] == rows[end - 1] + 1) {
+                ++end;
+            }
+            emit dataChanged(index(rows[begin], left), index(rows[end - 1], right), roles);
+        }
+    }
+
+    const QList<SortKey>& keys = m_comparer->keys();
+    const bool moved = std::any_of(keys.cbegin(), keys.cend(), [&](const SortKey& key) {
+        return key.column >= left && key.column <= right;
+    });
+    if (moved) {
+        QList<int> rows(count);
+        std::iota(rows.begin(), rows.end(), first);
+        placeRows(rows);
+    }
+}
+
+// ======================= TableFilterProxyModel =======================
+
+namespace {
+
+/**
+ * Evaluates matcher over rows [0, rows) of columns. When candidates is set, only those rows
+ * are tested and every other row is left unaccepted.
+ */
+RowBitmap scanRows(const RowMatcher& matcher, const QList<TableColumn>& columns, int rows,
+                   const std::optional<QList<int>>& candidates,
+                   const std::atomic<bool>* cancelled = nullptr) {
+    RowBitmap accepted(rows);
+    if (!candidates) {
+        matcher.evaluate(columns, 0, rows, accepted, cancelled);
+        return accepted;
+    }
+
+    // Candidates are scattered, so verify into a flag per candidate and set bits afterwards
+    // rather than letting threads write shared bitmap words.
+    QList<char> hits(candidates->size(), 0);
+    parallel::forChunks(candidates->size(), 256, [&](qsizetype begin, qsizetype end) {
+        for (qsizetype i = begin; i < end; ++i) {
+            if ((i & 1023) == 0 && cancelled != nullptr && cancelled->load()) {
+                return;
+            }
+            hits[i] = matcher.matchesRow(columns, (*candidates)[i]) ? 1 : 0;
+        }
+    });
+    for (qsizetype i = 0; i < candidates->size(); ++i) {
+        if (hits[i]) {
+            accepted.set((*candidates)[i]);
+        }
+    }
+    return accepted;
+}
+
+}  // namespace
+
+TableFilterProxyModel::TableFilterProxyModel(QObject* parent)
+    : QSortFilterProxyModel(parent),
+      m_order(new RowOrderProxyModel(this)),
+      m_tasks(std::make_unique<parallel::TaskGroup>()),
+      m_filterTasks(std::make_unique<parallel::TaskGroup>()),
+      m_sortTasks(std::make_unique<parallel::TaskGroup>()) {
+    connect(m_order, &RowOrderProxyModel::resortNeeded, this, &TableFilterProxyModel::resort);
+}
+
+TableFilterProxyModel::~TableFilterProxyModel() {
+    // Index builds, filter scans and sorts post their results back to this object.
+    m_tasks->cancelAndWait();
+    m_filterTasks->cancelAndWait();
+    m_sortTasks->cancelAndWait();
+}
+
+void TableFilterProxyModel::setSourceModel(QAbstractItemModel* sourceModel) {
+    for (const QMetaObject::Connection& connection : m_sourceConnections) {
+        disconnect(connection);
+    }
+    m_sourceConnections.clear();
+
+    m_source = qobject_cast<ColumnarTableModel*>(sourceModel);
+
+    // Connected before the order proxy connects its own handlers, so the bitmap is already
+    // up to date when QSortFilterProxyModel calls filterAcceptsRow() for the same change.
+    if (m_source != nullptr) {
+        m_sourceConnections = {
+            connect(m_source, &QAbstractItemModel::modelReset, this,
+                    [this]() {
+                        scheduleIndexBuild();
+                        rebuildBitmap();
+                        restartFilterScan();
+                        // The order proxy shows source order until this is resorted.
+                        restartSort();
+                        resort();
+                    }),
+            connect(m_source, &QAbstractItemModel::columnsInserted, this,
+                    [this]() {
+                        scheduleIndexBuild();
+                        rebuildBitmap();
+                        restartFilterScan();
+                        restartSort();
+                    }),
+            connect(m_source, &QAbstractItemModel::columnsRemoved, this,
+                    [this]() {
+                        scheduleIndexBuild();
+                        rebuildBitmap();
+                        restartFilterScan();
+                        restartSort();
+                    }),
+            connect(m_source, &QAbstractItemModel::rowsInserted, this,
+                    [this](const QModelIndex&, int first, int last) {
+                        indexRowsInserted(first, last - first + 1);
+                        if (m_matcher) {
+                            m_accepted.insert(first, last - first + 1);
+                            m_matcher->evaluate(m_source->columns(), first, last - first + 1,
+                                                m_accepted);
+                        }
+                        // Appends past the snapshots are caught up when results are installed
+                        if (first < m_filterSnapshotRows) {
+                            restartFilterScan();
+                        }
+                        if (first < m_sortSnapshotRows) {
+                            restartSort();
+                        }
+                    }),
+            connect(m_source, &QAbstractItemModel::rowsRemoved, this,
+                    [this](const QModelIndex&, int first, int last) {
+                        indexRowsRemoved(first, last - first + 1);
+                        if (m_matcher) {
+                            m_accepted.remove(first, last - first + 1);
+                        }
+                        restartFilterScan();
+                        restartSort();
+                    }),
+            connect(m_source, &ColumnarTableModel::rowsPermuted, this,
+                    [this](const QList<int>& order) {
+                        scheduleIndexBuild();
+                        if (m_matcher && m_accepted.size() == order.size()) {
+                            m_accepted.permute(order);
+                        } else {
+                            rebuildBitmap();
+                        }
+                        restartFilterScan();
+                        restartSort();
+                    }),
+            connect(m_source, &QAbstractItemModel::dataChanged, this,
+                    [this](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+                        const int first = topLeft.row();
+                        const int count = bottomRight.row() - first + 1;
+                        indexRowsChanged(first, count);
+                        if (m_matcher) {
+                            m_matcher->evaluate(m_source->columns(), first, count, m_accepted);
+                        }
+                        if (m_pendingMatcher) {
+                            for (int row = first; row < first + count; ++row) {
+                                m_filterPendingRows.append(row);
+                            }
+                        }
+
+                        // The order proxy places the rows by key for the installed sort; a
+                        // pending sort places them when it is installed.
+                        if (!m_pendingSorter) {
+                            return;
+                        }
+                        const QList<SortKey>& keys = m_pendingSorter->keys();
+                        if (std::any_of(keys.cbegin(), keys.cend(), [&](const SortKey& key) {
+                                return key.column >= topLeft.column() &&
+                                       key.column <= bottomRight.column();
+                            })) {
+                            for (int row = first; row < first + count; ++row) {
+                                m_sortPendingRows.append(row);
+                            }
+                        }
+                    }),
+        };
+    }
+
+    m_order->setSourceModel(m_source);
+    QSortFilterProxyModel::setSourceModel(m_order);
+    scheduleIndexBuild();
+    rebuildBitmap();
+    restartFilterScan();
+    restartSort();
+    resort();
+}
+
+void TableFilterProxyModel::setRowFilter(std::shared_ptr<const RowMatcher> matcher) {
+    QElapsedTimer clock;
+    clock.start();
+    cancelRowFilterAsync();
+
+    // The previous bitmap is a superset of the new result when the query only got longer.
+    const bool narrowing = m_matcher && matcher && m_source != nullptr &&
+                           m_accepted.size() == m_source->rowCount() &&
+                           matcher->narrows(*m_matcher);
+
+    m_matcher = std::move(matcher);
+    if (narrowing) {
+        m_matcher->refine(m_source->columns(), m_accepted);
+    } else {
+        rebuildBitmap();
+    }
+    invalidateRowsFilter();
+    emit rowFilterFinished(m_matcher ? m_accepted.count() : rowCount(), clock.elapsed());
+}
+
+void TableFilterProxyModel::setRowFilterAsync(std::shared_ptr<const RowMatcher> matcher) {
+    if (!matcher) {
+        clearRowFilter();
+        return;
+    }
+
+    cancelRowFilterAsync();
+    m_pendingMatcher = std::move(matcher);
+    m_filterClock.start();
+    startFilterScan();
+}
+
+void TableFilterProxyModel::cancelRowFilterAsync() {
+    m_filterTasks->cancel();
+    m_pendingMatcher.reset();
+    m_filterPendingRows.clear();
+    m_filterSnapshotRows = 0;
+    ++m_filterGeneration;
+}
+
+void TableFilterProxyModel::clearRowFilter() {
+    cancelRowFilterAsync();
+    m_matcher.reset();
+    m_accepted = RowBitmap();
+    invalidateRowsFilter();
+    emit rowFilterFinished(m_source != nullptr ? m_source->rowCount() : 0, 0);
+}
+
+int TableFilterProxyModel::sourceRow(int row) const {
+    return m_order->sourceRow(mapToSource(index(row, 0)).row());
+}
+
+bool TableFilterProxyModel::filterAcceptsRow(int sourceRow,
+                                             const QModelIndex& sourceParent) const {
+    if (!m_matcher || m_source == nullptr) {
+        return QSortFilterProxyModel::filterAcceptsRow(sourceRow, sourceParent);
+    }
+
+    // sourceRow is a row of the order proxy; the bitmap is by row of m_source.
+    const int row = m_order->sourceRow(sourceRow);
+    if (row < m_accepted.size()) {
+        return m_accepted.test(row);
+    }
+    return m_matcher->matchesRow(m_source->columns(), row);
+}
+
+void TableFilterProxyModel::rebuildBitmap() {
+    if (!m_matcher || m_source == nullptr) {
+        m_accepted = RowBitmap();
+        return;
+    }
+
+    m_accepted = scanRows(*m_matcher, m_source->columns(), m_source->rowCount(),
+                          indexCandidates(*m_matcher));
+}
+
+std::optional<QList<int>> TableFilterProxyModel::indexCandidates(
+    const RowMatcher& matcher) const {
+    if (!isTrigramIndexReady() ||
+        (m_index->column() >= 0 && m_index->column() != matcher.column())) {
+        return std::nullopt;
+    }
+    return m_index->candidates(matcher.requiredLiterals());
+}
+
+void TableFilterProxyModel::startFilterScan() {
+    ++m_filterGeneration;
+    m_filterPendingRows.clear();
+
+    if (m_source == nullptr) {
+        // Nothing to scan; install the filter as is.
+        setRowFilter(std::move(m_pendingMatcher));
+        return;
+    }
+
+    // The worker reads a snapshot. Appends and edits made meanwhile are evaluated when the
+    // result is installed; anything else restarts the scan.
+    const QList<TableColumn> columns = m_source->columns();
+    const int rows = m_source->rowCount();
+    const std::shared_ptr<const RowMatcher> matcher = m_pendingMatcher;
+    const quint64 generation = m_filterGeneration;
+    m_filterSnapshotRows = rows;
+
+    // A narrowing query only re-tests the rows the current filter accepts.
+    std::optional<RowBitmap> base;
+    std::optional<QList<int>> candidates;
+    if (m_matcher && m_accepted.size() == rows && matcher->narrows(*m_matcher)) {
+        base = m_accepted;
+    } else {
+        candidates = indexCandidates(*matcher);
+    }
+
+    m_filterTasks->start([this, columns, rows, matcher, generation, base,
+                          candidates](const std::atomic<bool>& cancelled) {
+        auto accepted = std::make_shared<RowBitmap>();
+        if (base) {
+            *accepted = *base;
+            matcher->refine(columns, *accepted, &cancelled);
+        } else {
+            *accepted = scanRows(*matcher, columns, rows, candidates, &cancelled);
+        }
+        if (cancelled) {
+            return;
+        }
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, matcher, accepted, generation]() {
+                if (generation != m_filterGeneration) {
+                    return;
+                }
+
+                const QList<TableColumn>& current = m_source->columns();
+                const int scanned = accepted->size();
+                const int total = m_source->rowCount();
+                accepted->resize(total);
+                if (total > scanned) {
+                    matcher->evaluate(current, scanned, total - scanned, *accepted);
+                }
+                for (int row : std::as_const(m_filterPendingRows)) {
+                    if (row < scanned) {
+                        accepted->set(row, matcher->matchesRow(current, row));
+                    }
+                }
+
+                m_matcher = matcher;
+                m_accepted = std::move(*accepted);
+                m_pendingMatcher.reset();
+                m_filterPendingRows.clear();
+                m_filterSnapshotRows = 0;
+                invalidateRowsFilter();
+                emit rowFilterFinished(m_accepted.count(), m_filterClock.elapsed());
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void TableFilterProxyModel::restartFilterScan() {
+    if (m_pendingMatcher) {
+        m_filterTasks->cancel();
+        startFilterScan();
+    }
+}
+
+void TableFilterProxyModel::setTrigramIndexEnabled(bool enabled, int column) {
+    if (enabled == m_indexEnabled && column == m_indexColumn) {
+        return;
+    }
+
+    m_indexEnabled = enabled;
+    m_indexColumn = column;
+    scheduleIndexBuild();
+}
+
+bool TableFilterProxyModel::isTrigramIndexReady() const {
+    return m_index && m_source != nullptr && m_index->rowCount() == m_source->rowCount();
+}
+
+void TableFilterProxyModel::scheduleIndexBuild() {
+    m_tasks->cancel();
+    m_index.reset();
+    m_indexPendingRows.clear();
+    m_indexBuilding = false;
+    ++m_indexGeneration;
+
+    if (!m_indexEnabled || m_source == nullptr) {
+        return;
+    }
+
+    // The worker reads a snapshot; rows appended or edited meanwhile are caught up when the
+    // result is installed, anything else starts a new generation.
+    const QList<TableColumn> columns = m_source->columns();
+    const int rows = m_source->rowCount();
+    const int column = m_indexColumn;
+    const quint64 generation = m_indexGeneration;
+    m_indexBuilding = true;
+
+    m_tasks->start([this, columns, rows, column, generation](const std::atomic<bool>& cancelled) {
+        auto index = std::make_shared<TrigramIndex>(
+            TrigramIndex::build(columns, rows, column, &cancelled));
+        if (cancelled) {
+            return;
+        }
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, index, generation]() {
+                if (generation != m_indexGeneration) {
+                    return;
+                }
+
+                const QList<TableColumn>& current = m_source->columns();
+                for (int row : std::as_const(m_indexPendingRows)) {
+                    if (row < index->rowCount()) {
+                        index->updateRow(current, row);
+                    }
+                }
+                index->appendRows(current, index->rowCount(),
+                                  m_source->rowCount() - index->rowCount());
+
+                m_index = std::move(*index);
+                m_indexPendingRows.clear();
+                m_indexBuilding = false;
+                emit trigramIndexReady();
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void TableFilterProxyModel::indexRowsInserted(int first, int count) {
+    // Appends are indexed in place (or caught up by a running build); anything bigger or
+    // shifting existing rows is cheaper to rebuild in the background.
+    constexpr int maxInPlace = 10000;
+
+    if (m_indexBuilding && first >= m_source->rowCount() - count) {
+        return;
+    }
+    if (m_index && first == m_index->rowCount() && count <= maxInPlace) {
+        m_index->appendRows(m_source->columns(), first, count);
+        return;
+    }
+    if (m_index || m_indexBuilding) {
+        scheduleIndexBuild();
+    }
+}
+
+void TableFilterProxyModel::indexRowsChanged(int first, int count) {
+    constexpr int maxInPlace = 10000;
+
+    if (count > maxInPlace) {
+        scheduleIndexBuild();
+        return;
+    }
+
+    for (int row = first; row < first + count; ++row) {
+        if (m_indexBuilding) {
+            m_indexPendingRows.append(row);
+        } else if (m_index && row < m_index->rowCount()) {
+            m_index->updateRow(m_source->columns(), row);
+        }
+    }
+}
+
+void TableFilterProxyModel::indexRowsRemoved(int first, int count) {
+    // A running build indexes a snapshot that still has the rows, so it starts over.
+    if (m_indexBuilding) {
+        scheduleIndexBuild();
+    } else if (m_index) {
+        m_index->removeRows(first, count);
+    }
+}
+
+void TableFilterProxyModel::sort(int column, Qt::SortOrder order) {
+    if (m_source == nullptr) {
+        QSortFilterProxyModel::sort(column, order);
+        return;
+    }
+
+    if (column < 0) {
+        m_sortTasks->cancel();
+        m_pendingSorter.reset();
+        m_sortSnapshotRows = 0;
+        m_sortPendingRows.clear();
+        ++m_sortGeneration;
+
+        m_sorter.reset();
+        m_order->clearOrder();
+        return;
+    }
+    sortRows(std::make_shared<RowSorter>(column, order));
+}
+
+void TableFilterProxyModel::sortRows(std::shared_ptr<const RowSorter> sorter) {
+    m_sortTasks->cancel();
+    m_pendingSorter = std::move(sorter);
+    m_sortClock.start();
+    startSort();
+}
+
+void TableFilterProxyModel::startSort() {
+    ++m_sortGeneration;
+    m_sortPendingRows.clear();
+    if (!m_pendingSorter || m_source == nullptr) {
+        m_pendingSorter.reset();
+        m_sortSnapshotRows = 0;
+        return;
+    }
+
+    const QList<TableColumn> columns = m_source->columns();
+    const int rows = m_source->rowCount();
+    const std::shared_ptr<const RowSorter> sorter = m_pendingSorter;
+    const quint64 generation = m_sortGeneration;
+    m_sortSnapshotRows = rows;
+
+    m_sortTasks->start(
+        [this, columns, rows, sorter, generation](const std::atomic<bool>& cancelled) {
+            auto keys = std::make_shared<QList<SortKey>>();
+            auto order = std::make_shared<QList<int>>(
+                sorter->sortedRows(columns, rows, &cancelled, keys.get()));
+            if (cancelled) {
+                return;
+            }
+
+            QMetaObject::invokeMethod(
+                this,
+                [this, sorter, order, keys, generation]() {
+                    if (generation != m_sortGeneration) {
+                        return;
+                    }
+
+                    // Rows appended or edited since the snapshot are placed by key. Too many
+                    // of them and the order proxy asks for a resort, which may start now.
+                    const QList<int> changed = std::exchange(m_sortPendingRows, {});
+                    m_pendingSorter.reset();
+                    m_sortSnapshotRows = 0;
+                    m_sorter = sorter;
+                    m_order->setOrder(*order, RowSorter(*keys, sorter->locale()), changed);
+                    emit sortFinished(m_sortClock.elapsed());
+                },
+                Qt::QueuedConnection);
+        });
+}
+
+void TableFilterProxyModel::restartSort() {
+    if (m_pendingSorter) {
+        m_sortTasks->cancel();
+        startSort();
+    }
+}
+
+void TableFilterProxyModel::resort() {
+    if (m_sorter && !m_pendingSorter) {
+        m_pendingSorter = m_sorter;
+        m_sortClock.start();
+        startSort();
+    }
+}
@@ -0,0 +1,625 @@
+#include "../include/TableImport.hpp"
+
+#include <QFile>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "Parallel.hpp"
+
+namespace {
+
+// Pieces are at least this large, so small inputs are parsed on one thread.
+constexpr qsizetype minPieceBytes = qsizetype(1) << 20;
+
+// Skips blank lines (LF or CRLF) at p.
+const char* skipBlankLines(const char* p, const char* end) {
+    while (p < end && (*p == '\n' || (*p == '\r' && p + 1 < end && p[1] == '\n'))) {
+        p += *p == '\n' ? 1 : 2;
+    }
+    return p;
+}
+
+/**
+ * Parses the record starting at p, calling field(index, bytes) for each field in order.
+ * Quoted fields with doubled quotes are unescaped into scratch; all others are passed as
+ * views of the input. Unterminated quotes run to the end of the input.
+ * @return Where the next record starts.
+ */
+template <typename Field>
+const char* parseRecord(const char* p, const char* end, char delimiter, QByteArray& scratch,
+                        const Field& field) {
+    for (int index = 0;; ++index) {
+        if (p < end && *p == '"') {
+            const char* run = ++p;
+            const char* close = end;
+            scratch.resize(0);
+            while (const void* found = std::memchr(p, '"', end - p)) {
+                const char* quote = static_cast<const char*>(found);
+                if (quote + 1 < end && quote[1] == '"') {
+                    scratch.append(run, quote + 1 - run);
+                    p = run = quote + 2;
+                    continue;
+                }
+                close = quote;
+                break;
+            }
+            if (scratch.isEmpty()) {
+                field(index, QByteArrayView(run, close - run));
+            } else {
+                scratch.append(run, close - run);
+                field(index, QByteArrayView(scratch));
+            }
+
+            // Text between a closing quote and the next separator is invalid; it is dropped.
+            p = close < end ? close + 1 : end;
+            while (p < end && *p != delimiter && *p != '\n') {
+                ++p;
+            }
+        } else {
+            const char* start = p;
+            while (p < end && *p != delimiter && *p != '\n') {
+                ++p;
+            }
+            const char* stop = p;
+            if (stop > start && stop[-1] == '\r' && (p == end || *p == '\n')) {
+                --stop;
+            }
+            field(index, QByteArrayView(start, stop - start));
+        }
+
+        if (p < end && *p == delimiter) {
+            ++p;
+            continue;
+        }
+        return p < end ? p + 1 : end;
+    }
+}
+
+/**
+ * Offsets in data at which pieces of roughly equal size start, each at a record boundary.
+ * Boundaries are found with the state machine parseRecord() follows: a quote opens a quoted
+ * field only at the start of a field (elsewhere it is text), and a newline ends a record
+ * unless it is inside quotes. Each slice is scanned in parallel from all four states at
+ * once, recording its first boundary and end state for each; the state in which each slice
+ * really starts is then chained through from the first, which starts a record.
+ */
+QList<qsizetype> pieceStarts(QByteArrayView data, char delimiter, qsizetype slices) {
+    // At a field's start, in an unquoted field (or past a quoted one's closing quote), in
+    // quotes, and just past a quote in quotes (escaped if another follows, else closing).
+    enum : quint8 { FieldStart, InField, Quoted, QuoteInQuoted };
+    enum : quint8 { Other, Quote, Newline, Delimiter };
+    static constexpr quint8 next[4][4] = {
+        {InField, InField, Quoted, InField},           // Other
+        {Quoted, InField, QuoteInQuoted, Quoted},      // Quote
+        {FieldStart, FieldStart, Quoted, FieldStart},  // Newline
+        {FieldStart, FieldStart, Quoted, FieldStart},  // Delimiter
+    };
+
+    // The four scans run in lockstep as two-bit lanes of one byte, lane k starting in
+    // state k, so each input byte costs one table lookup.
+    std::array<std::array<quint8, 256>, 4> step{};
+    for (int kind = 0; kind < 4; ++kind) {
+        for (int lanes = 0; lanes < 256; ++lanes) {
+            for (int lane = 0; lane < 4; ++lane) {
+                step[kind][lanes] |= next[kind][(lanes >> (2 * lane)) & 3] << (2 * lane);
+            }
+        }
+    }
+    std::array<quint8, 256> kindOf{};
+    kindOf[uchar(delimiter)] = Delimiter;
+    kindOf[uchar('"')] = Quote;
+    kindOf[uchar('\n')] = Newline;
+
+    struct Slice {
+        quint8 end = 0;                            // Final state of each lane
+        qsizetype newline[4] = {-1, -1, -1, -1};  // First record-ending newline, by start state
+    };
+
+    std::vector<Slice> scans(slices);
+    parallel::forEach(slices, [&](qsizetype i) {
+        const qsizetype begin = data.size() * i / slices;
+        const qsizetype end = data.size() * (i + 1) / slices;
+        Slice& slice = scans[i];
+        quint8 lanes = FieldStart | InField << 2 | Quoted << 4 | QuoteInQuoted << 6;
+        for (qsizetype at = begin; at < end; ++at) {
+            const quint8 kind = kindOf[uchar(data[at])];
+            if (kind == Newline) {
+                for (int lane = 0; lane < 4; ++lane) {
+                    if (slice.newline[lane] < 0 && ((lanes >> (2 * lane)) & 3) != Quoted) {
+                        slice.newline[lane] = at;
+                    }
+                }
+            }
+            lanes = step[kind][lanes];
+        }
+        slice.end = lanes;
+    });
+
+    QList<qsizetype> starts{0};
+    int state = FieldStart;
+    for (qsizetype i = 0; i < slices; ++i) {
+        const qsizetype newline = scans[i].newline[state];
+        if (i > 0 && newline >= 0 && newline + 1 < data.size()) {
+            starts.append(newline + 1);
+        }
+        state = (scans[i].end >> (2 * state)) & 3;
+    }
+    return starts;
+}
+
+// Records of one piece of the input, column by column.
+struct Piece {
+    std::vector<TableColumn> columns;
+    qsizetype rows = 0;
+};
+
+void parsePiece(const char* p, const char* end, int columns, const CsvImportOptions& options,
+                Piece& piece) {
+    // ASCII text takes one code unit per byte, so this is close for most data.
+    piece.columns.resize(columns);
+    for (TableColumn& column : piece.columns) {
+        column.reserve(0, (end - p) / qMax(1, columns));
+    }
+
+    QByteArray scratch;
+    p = skipBlankLines(p, end);
+    while (p < end) {
+        int filled = 0;
+        p = parseRecord(p, end, options.delimiter, scratch, [&](int index, QByteArrayView bytes) {
+            if (index >= columns) {
+                return;
+            }
+            TableColumn& column = piece.columns[index];
+            column.appendUtf8(bytes);
+            const int row = column.size() - 1;
+            if (!bytes.isEmpty() && options.nullTokens.contains(column.text(row))) {
+                column.set(row, QStringView());
+            }
+            filled = index + 1;
+        });
+        for (int col = filled; col < columns; ++col) {
+            piece.columns[col].append(QStringView());
+        }
+        ++piece.rows;
+        p = skipBlankLines(p, end);
+    }
+}
+
+bool isJsonSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+const char* skipJsonSpace(const char* p, const char* end) {
+    while (p < end && isJsonSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// Past the closing quote of the string starting at p, or nullptr if it doesn't close.
+const char* stringEnd(const char* p, const char* end) {
+    for (++p; p < end; ++p) {
+        if (*p == '\\') {
+            ++p;
+        } else if (*p == '"') {
+            return p + 1;
+        }
+    }
+    return nullptr;
+}
+
+// Past the bracket closing the object or array starting at p, or nullptr if it doesn't close.
+const char* compositeEnd(const char* p, const char* end) {
+    int depth = 0;
+    for (; p < end; ++p) {
+        if (*p == '"') {
+            p = stringEnd(p, end);
+            if (p == nullptr) {
+                return nullptr;
+            }
+            --p;
+        } else if (*p == '{' || *p == '[') {
+            ++depth;
+        } else if ((*p == '}' || *p == ']') && --depth == 0) {
+            return p + 1;
+        }
+    }
+    return nullptr;
+}
+
+// Value of four hex digits, or -1.
+int hexValue(QByteArrayView digits) {
+    int value = 0;
+    for (char c : digits) {
+        const char lower = char(c | 0x20);
+        int digit = -1;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (lower >= 'a' && lower <= 'f') {
+            digit = lower - 'a' + 10;
+        }
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+// Text of a JSON string body (between the quotes). Surrogate pairs written as two \u escapes
+// come out as the two UTF-16 code units they are.
+QString unescape(QByteArrayView text) {
+    if (!text.contains('\\')) {
+        return QString::fromUtf8(text);
+    }
+
+    QString out;
+    out.reserve(text.size());
+    qsizetype from = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        if (text[i] != '\\') {
+            continue;
+        }
+        out.append(QString::fromUtf8(text.sliced(from, i - from)));
+        if (++i == text.size()) {
+            from = i;
+            break;
+        }
+
+        switch (text[i]) {
+            case 'b':
+                out.append(u'\b');
+                break;
+            case 'f':
+                out.append(u'\f');
+                break;
+            case 'n':
+                out.append(u'\n');
+                break;
+            case 'r':
+                out.append(u'\r');
+                break;
+            case 't':
+                out.append(u'\t');
+                break;
+            case 'u': {
+                const int code = i + 4 < text.size() ? hexValue(text.sliced(i + 1, 4)) : -1;
+                out.append(code >= 0 ? QChar(char16_t(code)) : QChar(QChar::ReplacementCharacter));
+                if (code >= 0) {
+                    i += 4;
+                }
+                break;
+            }
+            default:  // \" \\ and \/
+                out.append(QLatin1Char(text[i]));
+        }
+        from = i + 1;
+    }
+    out.append(QString::fromUtf8(text.sliced(from)));
+    return out;
+}
+
+}  // namespace
+
+CsvImporter::CsvImporter(CsvImportOptions options) : m_options(std::move(options)) {}
+
+bool CsvImporter::read(const QString& path, ImportedTable& table) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = file.errorString();
+        return false;
+    }
+
+    uchar* mapped = file.size() > 0 ? file.map(0, file.size()) : nullptr;
+    if (mapped == nullptr) {
+        // Empty, or not mappable (e.g. a pipe): read it instead.
+        const QByteArray data = file.readAll();
+        return read(QByteArrayView(data), table);
+    }
+
+    const bool ok = read(QByteArrayView(reinterpret_cast<const char*>(mapped), file.size()), table);
+    file.unmap(mapped);
+    return ok;
+}
+
+bool CsvImporter::read(QByteArrayView data, ImportedTable& table) {
+    m_error.clear();
+    table = ImportedTable();
+
+    if (data.startsWith("\xEF\xBB\xBF")) {
+        data = data.sliced(3);
+    }
+    const char* p = skipBlankLines(data.data(), data.data() + data.size());
+    const char* end = data.data() + data.size();
+    if (p == end) {
+        return true;
+    }
+
+    // The first record fixes the column count and may name the columns.
+    QByteArray scratch;
+    QStringList first;
+    const char* next = parseRecord(p, end, m_options.delimiter, scratch,
+                                   [&first](int, QByteArrayView bytes) {
+                                       first.append(QString::fromUtf8(bytes));
+                                   });
+    const int columns = static_cast<int>(first.size());
+    if (m_options.headerRow) {
+        table.names = first;
+        p = next;
+    }
+
+    const QByteArrayView body(p, end - p);
+    const qsizetype slices =
+        qBound<qsizetype>(1, body.size() / minPieceBytes, 4 * parallel::idealThreadCount());
+    const QList<qsizetype> starts = pieceStarts(body, m_options.delimiter, slices);
+
+    std::vector<Piece> pieces(starts.size());
+    parallel::forEach(starts.size(), [&](qsizetype i) {
+        const qsizetype stop = i + 1 < starts.size() ? starts[i + 1] : body.size();
+        parsePiece(body.data() + starts[i], body.data() + stop, columns, m_options, pieces[i]);
+    });
+
+    qsizetype rows = 0;
+    for (const Piece& piece : pieces) {
+        rows += piece.rows;
+    }
+    if (rows > std::numeric_limits<int>::max()) {
+        m_error = QStringLiteral("Too many rows: %1").arg(rows);
+        return false;
+    }
+
+    // Pieces are joined column by column, releasing each column's pieces as it goes.
+    table.columns = QList<TableColumn>(columns);
+    TableColumn* joined = table.columns.data();
+    parallel::forEach(columns, [&](qsizetype col) {
+        QList<TableColumn> parts;
+        parts.reserve(static_cast<qsizetype>(pieces.size()));
+        for (Piece& piece : pieces) {
+            parts.append(std::move(piece.columns[col]));
+        }
+        joined[col] = TableColumn::concat(parts);
+    });
+    return true;
+}
+
+// ======================= JsonImporter =======================
+
+JsonImporter::JsonImporter(QStringList fieldNames, RowsReady rowsReady, int batchRows)
+    : m_fieldNames(std::move(fieldNames)),
+      m_fixedFields(!m_fieldNames.isEmpty()),
+      m_rowsReady(std::move(rowsReady)),
+      m_batchRows(qMax(1, batchRows)) {
+    for (int col = 0; col < m_fieldNames.size(); ++col) {
+        m_columns.insert(m_fieldNames[col], col);
+    }
+}
+
+bool JsonImporter::fail(const QString& error) {
+    m_error = error;
+    return false;
+}
+
+bool JsonImporter::feed(QByteArrayView data) {
+    if (!m_error.isEmpty()) {
+        return false;
+    }
+
+    m_buffer.append(data.data(), data.size());
+    if (m_consumed == 0 && m_scanned == 0 && m_buffer.startsWith("\xEF\xBB\xBF")) {
+        m_scanned = 3;
+    }
+
+    for (qsizetype i = m_scanned; i < m_buffer.size(); ++i) {
+        const char c = m_buffer[i];
+        if (m_inString) {
+            if (m_escape) {
+                m_escape = false;
+            } else if (c == '\\') {
+                m_escape = true;
+            } else if (c == '"') {
+                m_inString = false;
+            }
+            continue;
+        }
+
+        // Inside a row: track nesting until its closing brace
+        if (m_objectStart >= 0) {
+            if (c == '"') {
+                m_inString = true;
+            } else if (c == '{' || c == '[') {
+                ++m_depth;
+            } else if ((c == '}' || c == ']') && --m_depth == 0) {
+                const QByteArrayView object(m_buffer.constData() + m_objectStart,
+                                            i + 1 - m_objectStart);
+                if (!parseObject(object)) {
+                    return false;
+                }
+                m_objectStart = -1;
+            }
+            continue;
+        }
+
+        // Between rows
+        if (isJsonSpace(c)) {
+            continue;
+        }
+        if (!m_layout) {
+            m_layout = c == '[' ? JsonLayout::Array : JsonLayout::Lines;
+            if (c == '[') {
+                continue;
+            }
+        }
+        if (c == '{' && !m_ended) {
+            m_objectStart = i;
+            m_depth = 1;
+        } else if (*m_layout == JsonLayout::Array && !m_ended && (c == ',' || c == ']')) {
+            m_ended = c == ']';
+        } else {
+            return fail(QStringLiteral("Expected an object at byte %1").arg(m_consumed + i));
+        }
+    }
+
+    // Only the unfinished row is kept.
+    const qsizetype consumed = m_objectStart >= 0 ? m_objectStart : m_buffer.size();
+    m_buffer.remove(0, consumed);
+    m_consumed += consumed;
+    m_scanned = m_buffer.size();
+    if (m_objectStart >= 0) {
+        m_objectStart = 0;
+    }
+    return true;
+}
+
+bool JsonImporter::finish() {
+    // Rows parsed before any error are still handed out.
+    flush();
+    if (!m_error.isEmpty()) {
+        return false;
+    }
+    if (m_objectStart >= 0 || (m_layout == JsonLayout::Array && !m_ended)) {
+        return fail(QStringLiteral("Unexpected end of JSON"));
+    }
+    return true;
+}
+
+bool JsonImporter::read(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(file.errorString());
+    }
+
+    QByteArray block(qsizetype(1) << 20, Qt::Uninitialized);
+    for (;;) {
+        const qint64 size = file.read(block.data(), block.size());
+        if (size < 0) {
+            flush();
+            return fail(file.errorString());
+        }
+        if (size == 0) {
+            break;
+        }
+        if (!feed(QByteArrayView(block.constData(), size))) {
+            flush();
+            return false;
+        }
+    }
+    return finish();
+}
+
+bool JsonImporter::parseObject(QByteArrayView object) {
+    auto malformed = [this, object]() {
+        return fail(QStringLiteral("Malformed object at row %1: %2")
+                        .arg(m_rowCount + 1)
+                        .arg(QString::fromUtf8(object.first(qMin<qsizetype>(object.size(), 80)))));
+    };
+
+    QStringList row(m_fieldNames.size());
+    const char* p = object.data() + 1;  // Past the opening brace
+    const char* end = object.data() + object.size() - 1;
+    for (int position = 0;; ++position) {
+        p = skipJsonSpace(p, end);
+        if (p == end) {
+            break;
+        }
+
+        const char* keyEnd = *p == '"' ? stringEnd(p, end) : nullptr;
+        if (keyEnd == nullptr) {
+            return malformed();
+        }
+        const QByteArrayView rawKey(p + 1, keyEnd - p - 2);
+        p = skipJsonSpace(keyEnd, end);
+        if (p == end || *p != ':') {
+            return malformed();
+        }
+        p = skipJsonSpace(p + 1, end);
+        if (p == end) {
+            return malformed();
+        }
+
+        const char* valueStart = p;
+        QString value;
+        if (*p == '"') {
+            p = stringEnd(p, end);
+            if (p == nullptr) {
+                return malformed();
+            }
+            value = unescape(QByteArrayView(valueStart + 1, p - valueStart - 2));
+        } else if (*p == '{' || *p == '[') {
+            p = compositeEnd(p, end);
+            if (p == nullptr) {
+                return malformed();
+            }
+            value = QString::fromUtf8(valueStart, p - valueStart);
+        } else {
+            while (p < end && *p != ',' && !isJsonSpace(*p)) {
+                ++p;
+            }
+            const QByteArrayView literal(valueStart, p - valueStart);
+            if (literal.isEmpty()) {
+                return malformed();
+            }
+            if (literal != "null") {
+                value = QString::fromLatin1(literal);
+            }
+        }
+
+        const int column = columnFor(rawKey, position);
+        if (column >= 0) {
+            if (column >= row.size()) {
+                row.resize(column + 1);
+            }
+            row[column] = std::move(value);
+        }
+
+        p = skipJsonSpace(p, end);
+        if (p == end) {
+            break;
+        }
+        if (*p != ',') {
+            return malformed();
+        }
+        ++p;
+    }
+
+    m_rows.append(std::move(row));
+    ++m_rowCount;
+    if (m_rows.size() >= m_batchRows) {
+        flush();
+    }
+    return true;
+}
+
+int JsonImporter::columnFor(QByteArrayView rawKey, int position) {
+    if (position < m_keyOrder.size() && QByteArrayView(m_keyOrder[position]) == rawKey) {
+        return m_keyColumns[position];
+    }
+
+    const QString key = unescape(rawKey);
+    int column = m_columns.value(key, -1);
+    if (column < 0 && !m_fixedFields) {
+        column = static_cast<int>(m_fieldNames.size());
+        m_fieldNames.append(key);
+        m_columns.insert(key, column);
+    }
+
+    if (position >= m_keyOrder.size()) {
+        m_keyOrder.resize(position + 1);
+        m_keyColumns.resize(position + 1);
+    }
+    m_keyOrder[position] = rawKey.toByteArray();
+    m_keyColumns[position] = column;
+    return column;
+}
+
+void JsonImporter::flush() {
+    if (m_rows.isEmpty()) {
+        return;
+    }
+    if (m_rowsReady) {
+        m_rowsReady(m_rows);
+    }
+    m_rows.clear();
+}
@@ -0,0 +1,266 @@
+#include "../include/TableRenderer.hpp"
+
+#include <QFontMetricsF>
+#include <QPageSize>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QPrinter>
+#include <cmath>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "Parallel.hpp"
+
+namespace {
+
+// Matching the HTML table's CSS
+const QColor borderColor(0xdd, 0xdd, 0xdd);
+const QColor headerBackground(0xf2, 0xf2, 0xf2);
+
+// Rows measured when sizing columns; widths of larger tables are estimated from a sample.
+constexpr int measuredRows = 2000;
+
+// Text as painted on one line of width: line breaks become spaces, overflow is elided.
+QString fitted(const QFontMetricsF& metrics, QStringView text, qreal width) {
+    QString line = text.toString();
+    if (line.contains(u'\n')) {
+        line.replace(u'\n', u' ');
+    }
+    return metrics.elidedText(line, Qt::ElideRight, width);
+}
+
+}  // namespace
+
+TableRenderer::TableRenderer(TableSnapshot snapshot, QString title, QImage logo)
+    : m_snapshot(std::move(snapshot)), m_title(std::move(title)), m_logo(std::move(logo)) {}
+
+void TableRenderer::setFont(const QFont& font) {
+    m_font = font;
+}
+
+void TableRenderer::layout(QPaintDevice* device, const QRectF& pageRect) {
+    m_pageRect = pageRect;
+    m_dpi = device->logicalDpiY();
+
+    // Fonts are sized in device pixels, so metrics taken without the device (on any thread)
+    // match what is painted on it.
+    m_cellFont = m_font;
+    if (m_cellFont.pixelSize() <= 0) {
+        m_cellFont.setPixelSize(qMax(1, qRound(m_font.pointSizeF() * m_dpi / 72)));
+    }
+    m_headerFont = m_cellFont;
+    m_headerFont.setBold(true);
+    m_titleFont = m_headerFont;
+    m_titleFont.setPixelSize(qMax(1, qRound(px(18))));
+
+    const QFontMetricsF metrics(m_cellFont);
+    const QFontMetricsF headerMetrics(m_headerFont);
+
+    // Title and logo, each followed by its margin, then the block's bottom margin
+    m_headingHeight = 0;
+    if (!m_title.isEmpty()) {
+        m_headingHeight += QFontMetricsF(m_titleFont).height() + px(4);
+    }
+    if (!m_logo.isNull()) {
+        m_headingHeight += px(64);
+    }
+    if (m_headingHeight > 0) {
+        m_headingHeight += px(16);
+    }
+
+    const qreal padding = px(8);
+    m_rowHeight = qMax(metrics.height(), headerMetrics.height()) + 2 * padding;
+
+    // Natural column widths, each capped at half the page so one long column can't squeeze
+    // the rest to nothing, then scaled together to the page width.
+    const int columns = m_snapshot.columnCount();
+    const int rows = m_snapshot.rowCount();
+    const int step = qMax(1, rows / measuredRows);
+
+    m_columnWidths = QList<qreal>(columns, 0);
+    qreal total = 0;
+    QString buffer;
+    for (int col = 0; col < columns; ++col) {
+        qreal width = headerMetrics.horizontalAdvance(m_snapshot.names.value(col));
+        for (int row = 0; row < rows; row += step) {
+            width = qMax(width,
+                         metrics.horizontalAdvance(m_snapshot.cell(row, col, buffer).toString()));
+        }
+        width = qMin(width + 2 * padding, m_pageRect.width() / 2);
+        m_columnWidths[col] = width;
+        total += width;
+    }
+    if (total > 0) {
+        for (qreal& width : m_columnWidths) {
+            width *= m_pageRect.width() / total;
+        }
+    }
+
+    m_headerText.clear();
+    for (int col = 0; col < columns; ++col) {
+        m_headerText.append(fitted(headerMetrics, m_snapshot.names.value(col),
+                                   m_columnWidths[col] - 2 * padding));
+    }
+
+    const qreal bodyHeight = m_pageRect.height() - m_headingHeight - m_rowHeight;
+    m_rowsPerPage = qMax(1, int(std::floor(bodyHeight / m_rowHeight)));
+    m_pageCount = qMax(1, (rows + m_rowsPerPage - 1) / m_rowsPerPage);
+}
+
+QStringList TableRenderer::pageText(int page) const {
+    const int first = page * m_rowsPerPage;
+    const int last = qMin(m_snapshot.rowCount(), first + m_rowsPerPage);
+    const int columns = m_snapshot.columnCount();
+    const qreal padding = px(8);
+    const QFontMetricsF metrics(m_cellFont);
+
+    QStringList text;
+    QString buffer;
+    text.reserve(qMax(0, last - first) * columns);
+    for (int index = first; index < last; ++index) {
+        for (int col = 0; col < columns; ++col) {
+            text.append(fitted(metrics, m_snapshot.cell(index, col, buffer),
+                               m_columnWidths[col] - 2 * padding));
+        }
+    }
+    return text;
+}
+
+void TableRenderer::paintPage(QPainter& painter, int page) const {
+    if (page < 0 || page >= m_pageCount) {
+        return;
+    }
+    paintPage(painter, page, pageText(page));
+}
+
+void TableRenderer::paintPage(QPainter& painter, int page, const QStringList& text) const {
+    painter.save();
+
+    const qreal left = m_pageRect.left();
+    const qreal width = m_pageRect.width();
+    qreal y = m_pageRect.top();
+
+    if (!m_title.isEmpty()) {
+        painter.setFont(m_titleFont);
+        const qreal height = QFontMetricsF(m_titleFont).height();
+        painter.drawText(QRectF(left, y, width, height), Qt::AlignHCenter | Qt::AlignTop,
+                         m_title);
+        y += height + px(4);
+    }
+    if (!m_logo.isNull()) {
+        painter.drawImage(QRectF(left + (width - px(64)) / 2, y, px(64), px(64)), m_logo);
+    }
+    y = m_pageRect.top() + m_headingHeight;
+
+    const int first = page * m_rowsPerPage;
+    const int rows = qMax(0, qMin(m_snapshot.rowCount(), first + m_rowsPerPage) - first);
+    const int columns = m_snapshot.columnCount();
+    const qreal padding = px(8);
+    const qreal tableWidth = std::accumulate(m_columnWidths.cbegin(), m_columnWidths.cend(), 0.0);
+    const qreal tableHeight = m_rowHeight * (rows + 1);
+
+    // Cell text, one font per pass to avoid switching fonts per cell
+    auto paintRow = [&](qreal top, const QStringList& cells, qsizetype from) {
+        qreal x = left;
+        for (int col = 0; col < columns; ++col) {
+            const QRectF box(x + padding, top, m_columnWidths[col] - 2 * padding, m_rowHeight);
+            painter.drawText(box, Qt::AlignLeft | Qt::AlignVCenter | Qt::TextSingleLine,
+                             cells[from + col]);
+            x += m_columnWidths[col];
+        }
+    };
+
+    painter.fillRect(QRectF(left, y, tableWidth, m_rowHeight), headerBackground);
+    painter.setPen(Qt::black);
+
+    painter.setFont(m_headerFont);
+    paintRow(y, m_headerText, 0);
+
+    painter.setFont(m_cellFont);
+    for (int row = 0; row < rows; ++row) {
+        paintRow(y + m_rowHeight * (row + 1), text, qsizetype(row) * columns);
+    }
+
+    // Grid lines for the whole page at once
+    painter.setPen(QPen(borderColor, px(1)));
+    for (int line = 0; line <= rows + 1; ++line) {
+        const qreal lineY = y + m_rowHeight * line;
+        painter.drawLine(QPointF(left, lineY), QPointF(left + tableWidth, lineY));
+    }
+    qreal x = left;
+    for (int col = 0; col <= columns; ++col) {
+        painter.drawLine(QPointF(x, y), QPointF(x, y + tableHeight));
+        if (col < columns) {
+            x += m_columnWidths[col];
+        }
+    }
+
+    painter.restore();
+}
+
+bool TableRenderer::render(QPagedPaintDevice* device, int first, int last) {
+    QPainter painter;
+    if (!painter.begin(device)) {
+        return false;
+    }
+
+    // A painter records on one device serially, so what runs in parallel is the per-cell
+    // text shaping and eliding, a window of pages ahead of the painting.
+    const int window = 2 * parallel::idealThreadCount();
+    std::vector<QStringList> texts(window);
+    for (int start = first; start <= last; start += window) {
+        const int count = qMin(window, last - start + 1);
+        parallel::forEach(count, [&](qsizetype i) { texts[i] = pageText(start + int(i)); });
+
+        for (int i = 0; i < count; ++i) {
+            if (start + i > first) {
+                device->newPage();
+            }
+            paintPage(painter, start + i, texts[i]);
+        }
+    }
+    return painter.end();
+}
+
+bool TableRenderer::print(QPrinter* printer) {
+    layout(printer, QRectF(QPointF(0, 0), printer->pageRect(QPrinter::DevicePixel).size()));
+
+    int first = 0;
+    int last = m_pageCount - 1;
+    if (printer->printRange() == QPrinter::PageRange && printer->fromPage() > 0) {
+        first = printer->fromPage() - 1;
+        last = qMin(last, printer->toPage() - 1);
+    }
+    return render(printer, first, last);
+}
+
+bool TableRenderer::writePdf(QPdfWriter* writer) {
+    if (!m_title.isEmpty()) {
+        writer->setTitle(m_title);
+    }
+    const QRect paintRect = writer->pageLayout().paintRectPixels(writer->resolution());
+    layout(writer, QRectF(QPointF(0, 0), paintRect.size()));
+    return render(writer, 0, m_pageCount - 1);
+}
+
+bool TableRenderer::writePdf(const QString& fileName) {
+    QPdfWriter writer(fileName);
+    writer.setResolution(300);
+    writer.setPageSize(QPageSize(QPageSize::A4));
+    writer.setPageMargins(QMarginsF(15, 15, 15, 15), QPageLayout::Millimeter);
+    return writePdf(&writer);
+}
+
+QImage TableRenderer::loadImage(const QUrl& url) {
+    if (url.isEmpty()) {
+        return {};
+    }
+    if (url.isLocalFile()) {
+        return QImage(url.toLocalFile());
+    }
+    if (url.scheme() == QLatin1String("qrc")) {
+        return QImage(QLatin1Char(':') + url.path());
+    }
+    return QImage(url.toString());
+}
@@ -0,0 +1,269 @@
+#include "../include/TableSort.hpp"
+
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <QDateTime>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Parallel.hpp"
+
+namespace {
+
+// Negative, zero or positive as x sorts before, with or after y; NaN (no value) first.
+int compareNumbers(double x, double y) {
+    if (std::isnan(x) || std::isnan(y)) {
+        return int(!std::isnan(x)) - int(!std::isnan(y));
+    }
+    return x < y ? -1 : (y < x ? 1 : 0);
+}
+
+// Compares rows a and b of a typed column by their values, nulls first.
+int compareValues(const TableColumn& column, int a, int b) {
+    if (column.type() == ColumnType::Double) {
+        return compareNumbers(column.number(a), column.number(b));
+    }
+    const qint64 x = column.integer(a);
+    const qint64 y = column.integer(b);
+    return x < y ? -1 : (y < x ? 1 : 0);
+}
+
+// Text as a number, in C or else locale format; NaN if it isn't one.
+double toNumber(QStringView text, const QLocale& locale) {
+    bool ok = false;
+    double value = text.toDouble(&ok);
+    if (!ok) {
+        value = locale.toDouble(text, &ok);
+    }
+    return ok ? value : std::numeric_limits<double>::quiet_NaN();
+}
+
+// Text as an ISO 8601 date-time or date in milliseconds since the epoch; NaN if it isn't one.
+double toDateTime(QStringView text) {
+    const QString string = text.toString();
+    QDateTime value = QDateTime::fromString(string, Qt::ISODate);
+    if (!value.isValid()) {
+        value = QDate::fromString(string, Qt::ISODate).startOfDay();
+    }
+    return value.isValid() ? double(value.toMSecsSinceEpoch())
+                           : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * Precomputed sort keys of one column, indexed by row. Numbers and dates are kept as
+ * doubles (dates as milliseconds since the epoch) with NaN for empty or unparsable cells;
+ * text as collation keys. Typed columns need no keys unless sorted as text: their values
+ * are compared in place, nulls first like NaN. Encoded columns get one key per dictionary
+ * entry, looked up by code.
+ */
+class ColumnKeys {
+   public:
+    ColumnKeys(const TableColumn& column, int rows, SortKeyType type, const QLocale& locale,
+               const std::atomic<bool>* cancelled)
+        : m_column(column),
+          m_keys(column.isEncoded() ? column.dictionarySize() : rows),
+          m_locale(locale),
+          m_cancelled(cancelled) {
+        if (column.isTyped() && type != SortKeyType::Text) {
+            m_native = true;
+            m_type = type;
+            return;
+        }
+        switch (type) {
+            case SortKeyType::Auto:
+                if (parse(&ColumnKeys::toNumber, true)) {
+                    m_type = SortKeyType::Number;
+                } else if (parse(&ColumnKeys::toDateTime, true)) {
+                    m_type = SortKeyType::DateTime;
+                } else {
+                    collate();
+                }
+                break;
+            case SortKeyType::Text:
+                collate();
+                break;
+            case SortKeyType::Number:
+                parse(&ColumnKeys::toNumber, false);
+                m_type = type;
+                break;
+            case SortKeyType::DateTime:
+                parse(&ColumnKeys::toDateTime, false);
+                m_type = type;
+                break;
+        }
+    }
+
+    // How the cells are compared, Auto resolved to what the column's cells turned out to be.
+    [[nodiscard]] SortKeyType type() const { return m_type; }
+
+    // Negative, zero or positive as row a sorts before, with or after row b.
+    [[nodiscard]] int compare(int a, int b) const {
+        if (m_native) {
+            return compareValues(m_column, a, b);
+        }
+        if (m_text.empty()) {
+            return compareNumbers(m_values[key(a)], m_values[key(b)]);
+        }
+        return m_text[key(a)]->compare(*m_text[key(b)]);
+    }
+
+   private:
+    using Parser = double (ColumnKeys::*)(QStringView) const;
+
+    // Index of row's key: its dictionary code if the column is encoded.
+    [[nodiscard]] qsizetype key(int row) const {
+        return m_column.isEncoded() ? qsizetype(m_column.code(row)) : row;
+    }
+
+    // Text the key at index is made from.
+    [[nodiscard]] QStringView keyText(qsizetype index, QString& buffer) const {
+        return m_column.isEncoded() ? m_column.entry(index) : m_column.text(int(index), buffer);
+    }
+
+    [[nodiscard]] bool isCancelled() const {
+        return m_cancelled != nullptr && m_cancelled->load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] double toNumber(QStringView text) const { return ::toNumber(text, m_locale); }
+
+    [[nodiscard]] double toDateTime(QStringView text) const { return ::toDateTime(text); }
+
+    // Fills m_values with parser. When strict, gives up (returning false) as soon as a
+    // non-empty cell fails to parse.
+    bool parse(Parser parser, bool strict) {
+        m_values.assign(m_keys, std::numeric_limits<double>::quiet_NaN());
+        std::atomic<bool> failed{false};
+
+        parallel::forChunks(m_keys, 4096, [&](qsizetype begin, qsizetype end) {
+            QString buffer;
+            for (qsizetype index = begin; index < end; ++index) {
+                if ((index & 1023) == 0 && (failed.load() || isCancelled())) {
+                    return;
+                }
+                const QStringView text = keyText(index, buffer);
+                if (text.isEmpty()) {
+                    continue;
+                }
+                m_values[index] = (this->*parser)(text);
+                if (strict && std::isnan(m_values[index])) {
+                    failed = true;
+                    return;
+                }
+            }
+        });
+        return !failed;
+    }
+
+    void collate() {
+        m_values.clear();
+        m_text.assign(m_keys, std::nullopt);
+
+        parallel::forChunks(m_keys, 4096, [&](qsizetype begin, qsizetype end) {
+            // One collator per chunk; collators are not meant to be shared between threads.
+            const QCollator collator(m_locale);
+            QString buffer;
+            for (qsizetype index = begin; index < end; ++index) {
+                if ((index & 1023) == 0 && isCancelled()) {
+                    return;
+                }
+                m_text[index].emplace(collator.sortKey(keyText(index, buffer).toString()));
+            }
+        });
+    }
+
+    const TableColumn& m_column;
+    int m_keys;  // Rows, or dictionary entries if the column is encoded
+    const QLocale& m_locale;
+    const std::atomic<bool>* m_cancelled;
+    bool m_native = false;  // Compare the typed column's values directly
+    SortKeyType m_type = SortKeyType::Text;
+    std::vector<double> m_values;
+    std::vector<std::optional<QCollatorSortKey>> m_text;
+};
+
+}  // namespace
+
+RowSorter::RowSorter(int column, Qt::SortOrder order, SortKeyType type, const QLocale& locale)
+    : RowSorter(QList<SortKey>{{column, order, type}}, locale) {}
+
+RowSorter::RowSorter(QList<SortKey> keys, const QLocale& locale)
+    : m_keys(std::move(keys)), m_locale(locale), m_collator(locale) {}
+
+int RowSorter::compareRows(const QList<TableColumn>& columns, int a, int b) const {
+    QString bufferA;
+    QString bufferB;
+    for (const SortKey& key : m_keys) {
+        if (key.column < 0 || key.column >= columns.size()) {
+            continue;
+        }
+        const TableColumn& column = columns[key.column];
+
+        int result = 0;
+        if (column.isTyped() && key.type != SortKeyType::Text) {
+            result = compareValues(column, a, b);
+        } else {
+            const QStringView x = column.text(a, bufferA);
+            const QStringView y = column.text(b, bufferB);
+            switch (key.type) {
+                case SortKeyType::Number:
+                    result = compareNumbers(toNumber(x, m_locale), toNumber(y, m_locale));
+                    break;
+                case SortKeyType::DateTime:
+                    result = compareNumbers(toDateTime(x), toDateTime(y));
+                    break;
+                case SortKeyType::Auto:
+                case SortKeyType::Text:
+                    result = m_collator.compare(x, y);
+                    break;
+            }
+        }
+        if (result != 0) {
+            return key.order == Qt::DescendingOrder ? -result : result;
+        }
+    }
+    return 0;
+}
+
+QList<int> RowSorter::sortedRows(const QList<TableColumn>& columns, int rows,
+                                 const std::atomic<bool>* cancelled,
+                                 QList<SortKey>* resolved) const {
+    QList<int> order(rows);
+    for (int row = 0; row < rows; ++row) {
+        order[row] = row;
+    }
+
+    // Composite key: one precomputed key array per level, compared in level order.
+    std::vector<ColumnKeys> levels;
+    std::vector<bool> descending;
+    levels.reserve(m_keys.size());
+    for (const SortKey& key : m_keys) {
+        if (key.column < 0 || key.column >= columns.size()) {
+            continue;
+        }
+        levels.emplace_back(columns[key.column], rows, key.type, m_locale, cancelled);
+        descending.push_back(key.order == Qt::DescendingOrder);
+        if (resolved != nullptr) {
+            resolved->append({key.column, key.order, levels.back().type()});
+        }
+        if (cancelled != nullptr && cancelled->load()) {
+            return {};
+        }
+    }
+    if (levels.empty()) {
+        return order;
+    }
+
+    parallel::stableSort(order, [&levels, &descending](int a, int b) {
+        for (std::size_t level = 0; level < levels.size(); ++level) {
+            const int result = levels[level].compare(a, b);
+            if (result != 0) {
+                return descending[level] ? result > 0 : result < 0;
+            }
+        }
+        return false;
+    });
+    return order;
+}
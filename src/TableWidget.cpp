@@ -1,34 +1,101 @@
 #include "../include/TableWidget.hpp"
 
+#include <algorithm>
 #include <utility>
 
+#include "Parallel.hpp"
+
 // =============== HtmlPreviewWidget oveerides paintEvent =========
-HtmlPreviewWidget::HtmlPreviewWidget(QString html) : htmlContent(std::move(html)) {
+HtmlPreviewWidget::HtmlPreviewWidget(QString html)
+    : htmlContent(std::move(html)), layoutTasks(std::make_unique<parallel::TaskGroup>()) {
     updatePreview();
 }
 
+HtmlPreviewWidget::~HtmlPreviewWidget() {
+    // Layout jobs post their pages back to this widget.
+    layoutTasks->cancelAndWait();
+}
+
 void HtmlPreviewWidget::paintEvent(QPaintEvent* event) {
     QPrintPreviewWidget::paintEvent(event);
 
+    // Until a relayout for a new size lands, the previous pages are shown as they are.
     QPainter painter(this);
-    QTextDocument doc;
+    for (qsizetype page = 0; page < pages.size(); ++page) {
+        painter.drawPixmap(QPointF(0, page * pageSize.height()), pages[page]);
+    }
+}
 
-    doc.setHtml(htmlContent);
-    doc.setDefaultTextOption(QTextOption(Qt::AlignLeft | Qt::AlignTop));
-    doc.setPageSize(size());
+void HtmlPreviewWidget::resizeEvent(QResizeEvent* event) {
+    QPrintPreviewWidget::resizeEvent(event);
+    scheduleLayout();
+}
 
-    painter.save();
-    painter.translate(rect().topLeft());
+void HtmlPreviewWidget::scheduleLayout() {
+    // A running job re-checks the size when it finishes.
+    if (layoutRunning || size() == pageSize || size().isEmpty()) {
+        return;
+    }
 
-    // Draw the document's contents
-    doc.drawContents(&painter);
-    painter.restore();
+    layoutRunning = true;
+    const QSize size = this->size();
+    const qreal ratio = devicePixelRatioF();
+    layoutTasks->start([this, size, ratio, html = htmlContent,
+                        doc = document](const std::atomic<bool>& cancelled) mutable {
+        // Between jobs the document belongs to no thread; each job takes it over, so its
+        // layout objects start timers and emit signals only on the thread using them.
+        if (doc) {
+            doc->moveToThread(QThread::currentThread());
+        } else {
+            doc = std::make_shared<QTextDocument>();
+            doc->setHtml(html);
+            doc->setDefaultTextOption(QTextOption(Qt::AlignLeft | Qt::AlignTop));
+        }
+        doc->setPageSize(size);
+
+        // Pages are as tall as the widget, so only the first is in view; the rest are laid
+        // out but not rendered.
+        QList<QImage> images;
+        const int visible = qMin(doc->pageCount(), 1);
+        for (int page = 0; page < visible && !cancelled.load(); ++page) {
+            QImage image(size * ratio, QImage::Format_ARGB32_Premultiplied);
+            image.setDevicePixelRatio(ratio);
+            image.fill(Qt::transparent);
+
+            QPainter painter(&image);
+            const QRectF area(0, page * size.height(), size.width(), size.height());
+            painter.translate(0, -area.top());
+            doc->drawContents(&painter, area);
+            painter.end();
+            images.append(std::move(image));
+        }
+        doc->moveToThread(nullptr);
+        if (cancelled.load()) {
+            return;
+        }
+
+        // The GUI thread keeps it for the next job, and may destroy it.
+        QMetaObject::invokeMethod(
+            this,
+            [this, size, images, doc]() {
+                layoutRunning = false;
+                document = doc;
+                pageSize = size;
+                pages.clear();
+                for (const QImage& image : images) {
+                    pages.append(QPixmap::fromImage(image));
+                }
+                update();
+                scheduleLayout();
+            },
+            Qt::QueuedConnection);
+    });
 }
 
 // =================== CustomTableModel overrides flags ===========================
 CustomTableModel::CustomTableModel(const QList<int>& editableColumns,
                                    const QList<int>& disabledColumns, QObject* parent)
-    : QStandardItemModel(parent),
+    : ColumnarTableModel(parent),
       editableColumns(editableColumns),
       disabledColumns(disabledColumns) {}
 
@@ -45,7 +112,7 @@ Qt::ItemFlags CustomTableModel::flags(const QModelIndex& index) const {
         return Qt::ItemFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
     }
 
-    return QStandardItemModel::flags(index);
+    return ColumnarTableModel::flags(index);
 }
 
 // override setData to handle custom behavior
@@ -53,7 +120,7 @@ bool CustomTableModel::setData(const QModelIndex& index, const QVariant& value,
     if (role == Qt::EditRole) {
         // Check if the column is editable
         if (editableColumns.contains(index.column())) {
-            return QStandardItemModel::setData(index, value, role);
+            return ColumnarTableModel::setData(index, value, role);
         }
     }
     return false;
@@ -74,17 +141,26 @@ QList<int> CustomTableModel::getDisabledColumns() const {
      */
 TableWidget::TableWidget(QWidget* parent, const QList<int>& editableColumns,
                          const QList<int>& disabledColumns)
-    : QTableView(parent) {
+    : QTableView(parent), exportTasks(std::make_unique<parallel::TaskGroup>()) {
     tableModel = new CustomTableModel(editableColumns, disabledColumns, this);
+    tableModel->setNullTokens({"null", "undefined"});
 
     setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed);
 
-    proxyModel = new QSortFilterProxyModel(this);
+    proxyModel = new TableFilterProxyModel(this);
 
     proxyModel->setSourceModel(tableModel);
     proxyModel->setFilterKeyColumn(-1);
     setModel(proxyModel);
 
+    connect(proxyModel, &TableFilterProxyModel::rowFilterFinished, this,
+            &TableWidget::filterFinished);
+    connect(proxyModel, &TableFilterProxyModel::sortFinished, this, &TableWidget::sortFinished);
+
+    filterTimer = new QTimer(this);
+    filterTimer->setSingleShot(true);
+    connect(filterTimer, &QTimer::timeout, this, &TableWidget::applyPendingFilter);
+
     // Set default properties
     setSelectionMode(QAbstractItemView::SingleSelection);
     setSelectionBehavior(QAbstractItemView::SelectRows);
@@ -102,6 +178,9 @@ TableWidget::TableWidget(QWidget* parent, const QList<int>& editableColumns,
 
 // Destructor
 TableWidget::~TableWidget() {
+    // Exports post their progress back to this widget.
+    exportTasks->cancelAndWait();
+
     tableModel->deleteLater();
     proxyModel->deleteLater();
 }
@@ -136,6 +215,52 @@ void TableWidget::interactive() {
 // Sets the column to filter on. Default -1 (all columns)
 void TableWidget::setFilterKeyColumn(int column) {
     proxyModel->setFilterKeyColumn(column);
+
+    // Re-run an active or pending filter against the new column
+    if (const auto& pending = proxyModel->pendingRowFilter();
+        pending && pending->column() != column) {
+        proxyModel->setRowFilterAsync(std::make_shared<RowMatcher>(pending->regex(), column));
+    } else if (const auto& matcher = proxyModel->rowFilter();
+               matcher && matcher->column() != column) {
+        proxyModel->setRowFilter(std::make_shared<RowMatcher>(matcher->regex(), column));
+    }
+}
+
+void TableWidget::setSearchIndexEnabled(bool enabled, int column) {
+    proxyModel->setTrigramIndexEnabled(enabled, column);
+}
+
+void TableWidget::sortTable(int column, Qt::SortOrder order, SortKeyType type) {
+    if (column < 0 || column >= columnCount()) {
+        return;
+    }
+
+    horizontalHeader()->setSortIndicator(column, order);
+    proxyModel->sortRows(std::make_shared<RowSorter>(column, order, type));
+}
+
+void TableWidget::sortTable(const QList<QPair<int, Qt::SortOrder>>& columns) {
+    QList<SortKey> keys;
+    for (const auto& [column, order] : columns) {
+        if (column >= 0 && column < columnCount()) {
+            keys.append({column, order});
+        }
+    }
+    if (keys.isEmpty()) {
+        return;
+    }
+
+    // The header can only show the primary key.
+    horizontalHeader()->setSortIndicator(keys.first().column, keys.first().order);
+    proxyModel->sortRows(std::make_shared<RowSorter>(std::move(keys)));
+}
+
+void TableWidget::setFilterDebounce(int ms) {
+    filterDebounceMs = qMax(0, ms);
+}
+
+int TableWidget::filterDebounce() const {
+    return filterDebounceMs;
 }
 
 void TableWidget::setContextMenuEnabled(bool enabled) {
@@ -146,7 +271,8 @@ void TableWidget::setContextMenuEnabled(bool enabled) {
 // fieldNames should be equal in length to horizontalHeaders(otherwise won't be used)
 // fieldNames are used in generating JSON and CSV data.
 void TableWidget::setHorizontalHeaders(const QStringList& horizontalHeaders,
-                                       const QStringList& fields) {
+                                       const QStringList& fields,
+                                       const QList<ColumnType>& schema) {
     // set headers
     headers = horizontalHeaders;
 
@@ -157,12 +283,19 @@ void TableWidget::setHorizontalHeaders(const QStringList& horizontalHeaders,
 
     // Set the field names
     fieldNames = fields;
+    jsonFieldsDiscovered = false;
+
+    // Typed columns are converted now; rows loaded later are parsed once on the way in.
+    if (!schema.isEmpty()) {
+        tableModel->setColumnTypes(schema);
+    }
 }
 
 // fieldNames should be equal in length to horizontalHeaders(otherwise won't be used)
 // fieldNames are used in generating JSON and CSV data.
 void TableWidget::setFieldNames(const QStringList& fieldNames_) {
     fieldNames = fieldNames_;
+    jsonFieldsDiscovered = false;
 }
 
 // Sets vertical headers for the table.
@@ -193,119 +326,235 @@ void TableWidget::resetHeaders() {
      * Populates the table with data.
      */
 void TableWidget::setData(const QVector<QStringList>& data) {
-    tableModel->clear();
-    tableModel->setRowCount((int)data.size());
-    tableModel->setColumnCount(0);
+    // The column count comes from the first row, as before
+    const int columns = data.isEmpty() ? 0 : (int)data[0].size();
 
-    // Update the column count
-    if (!data.isEmpty()) {
-        tableModel->setColumnCount((int)data[0].size());
+    // Load and relabel inside one batch so views see a single reset
+    tableModel->beginBatch();
+    tableModel->resetRows(data, columns);
+    resetHeaders();
+    tableModel->endBatch();
+
+    notifyTableChanged();
+}
+
+void TableWidget::refreshData(const QVector<QStringList>& data, int keyColumn) {
+    if (tableModel->columnCount() == 0 || !tableModel->refreshRows(data, keyColumn)) {
+        setData(data);
+        return;
     }
+    notifyTableChanged();
+}
 
-    // Update the headers because the table was cleared
-    resetHeaders();
+bool TableWidget::setQuery(DatabaseConnection& connection, const QString& sql, int pageSize,
+                           int windowRows) {
+    if (!connection.isOpen()) {
+        queryError = "Cannot execute query: connection is not open";
+        return false;
+    }
+    queryError.clear();
 
-    for (int row = 0; row < data.size(); ++row) {
-        const QStringList& rowDataList = data[row];
-        for (int column = 0; column < rowDataList.size(); ++column) {
-            QString text = rowDataList[column];
+    tableModel->beginBatch();
+    const bool ok = tableModel->bindQuery(connection.database(), sql, pageSize, windowRows);
+    if (ok && !headers.isEmpty()) {
+        resetHeaders();
+    }
+    tableModel->endBatch();
 
-            if (text == "null" || text == "undefined") {
-                text = "";
-            }
-            auto* item = new QStandardItem(text);
-            tableModel->setItem(row, column, item);
-        }
+    if (ok) {
+        notifyTableChanged();
     }
-    emit tableChanged();
+    return ok;
 }
 
-// Sets the signals and slots for double click on table. Calls handler with data for
-// the double-clicked row.
-void TableWidget::setDoubleClickHandler(
-    std::function<void(int row, int col, const QStringList& data)> handler) {
-    doubleClickHandler = std::move(handler);
+QString TableWidget::lastQueryError() const {
+    return queryError.isEmpty() ? tableModel->queryError() : queryError;
 }
 
-// Generates an html table and writes it to a QString that is returned.
-QString TableWidget::generateHtmlTable() {
-    QString html;
+bool TableWidget::importCsv(const QString& path, bool headerRow) {
+    CsvImportOptions options;
+    options.headerRow = headerRow;
+    options.nullTokens = tableModel->nullTokens();
 
-    int rowCount = model()->rowCount();
-    int columnCount = model()->columnCount();
+    CsvImporter importer(options);
+    ImportedTable table;
+    if (!importer.read(path, table)) {
+        importError = importer.errorString();
+        return false;
+    }
+    importError.clear();
 
-    // Start the HTML table with CSS styles
-    html += "<table style='border-collapse: collapse; width: 100%;'>";
+    // Load and relabel inside one batch so views see a single reset
+    tableModel->beginBatch();
+    tableModel->resetColumns(std::move(table.columns));
+    if (headerRow) {
+        headers = table.names;
+    }
+    resetHeaders();
+    tableModel->endBatch();
 
-    // Generate table headers with CSS styles
-    html += "<thead><tr>";
-    for (int col = 0; col < columnCount; ++col) {
-        html += "<th style='border: 1px solid #ddd; padding: 8px; background-color: #f2f2f2;'>";
-        html += model()->headerData(col, Qt::Horizontal).toString();
-        html += "</th>";
+    notifyTableChanged();
+    return true;
+}
+
+void TableWidget::beginJsonImport(int batchRows) {
+    // Names an earlier import discovered are not keys to map this document to.
+    const QStringList keys = jsonFieldsDiscovered ? QStringList() : fieldNames;
+    const bool discover = keys.isEmpty();
+    if (discover) {
+        headers.clear();
+        fieldNames.clear();
     }
-    html += "</tr></thead>";
+    jsonFieldsDiscovered = discover;
 
-    // Generate table rows with CSS styles
-    html += "<tbody>";
-    for (int row = 0; row < rowCount; ++row) {
-        html += "<tr>";
-        for (int col = 0; col < columnCount; ++col) {
-            html += "<td style='border: 1px solid #ddd; padding: 8px;'>";
-            html += model()->data(model()->index(row, col)).toString();
-            html += "</td>";
-        }
-        html += "</tr>";
+    // The rows are all new, so labels of the old ones would only pad the table.
+    verticalHeaders.clear();
+
+    tableModel->beginBatch();
+    tableModel->resetRows({}, static_cast<int>(keys.size()));
+    tableModel->setVerticalHeaderLabels({});
+    resetHeaders();
+    tableModel->endBatch();
+    importError.clear();
+
+    jsonImport = std::make_unique<JsonImporter>(
+        keys,
+        [this, discover](const QVector<QStringList>& rows) {
+            const QStringList& found = jsonImport->fieldNames();
+            if (discover && found.size() > tableModel->columnCount()) {
+                headers = found;
+                fieldNames = found;
+                tableModel->setHorizontalHeaderLabels(found);
+            }
+            tableModel->appendRows(rows);
+        },
+        batchRows);
+}
+
+bool TableWidget::feedJson(QByteArrayView data) {
+    if (!jsonImport) {
+        importError = "No JSON import in progress";
+        return false;
     }
-    html += "</tbody>";
+    if (!jsonImport->feed(data)) {
+        importError = jsonImport->errorString();
+        return false;
+    }
+    return true;
+}
 
-    // End the HTML table
-    html += "</table>";
+bool TableWidget::endJsonImport() {
+    if (!jsonImport) {
+        importError = "No JSON import in progress";
+        return false;
+    }
+
+    const bool ok = jsonImport->finish();
+    importError = jsonImport->errorString();
+    jsonImport.reset();
 
-    return html;
+    notifyTableChanged();
+    return ok;
 }
 
-// Generates and returns QString containing CSV for the table data.
-QString TableWidget::generateCsvData() {
-    QString csv;
+bool TableWidget::importJson(const QString& path) {
+    beginJsonImport();
 
-    int rowCount = model()->rowCount();
-    int columnCount = model()->columnCount();
+    // read() finishes the import itself.
+    const bool ok = jsonImport->read(path);
+    importError = jsonImport->errorString();
+    jsonImport.reset();
 
-    if (useFields()) {
-        // Generate CSV headers
-        for (int col = 0; col < columnCount; ++col) {
-            if (col > 0) {
-                csv += ",";
-            }
-            csv += "\"" + fieldNames[col] + "\"";
+    notifyTableChanged();
+    return ok;
+}
+
+bool TableWidget::saveSnapshot(const QString& path) const {
+    QVariantMap metadata;
+    metadata.insert("headers", headers);
+    metadata.insert("fieldNames", fieldNames);
+    metadata.insert("verticalHeaders", verticalHeaders);
+    return tableModel->saveSnapshot(path, metadata);
+}
+
+bool TableWidget::loadSnapshot(const QString& path) {
+    QVariantMap metadata;
+
+    // Load and relabel inside one batch so views see a single reset
+    tableModel->beginBatch();
+    const bool ok = tableModel->loadSnapshot(path, &metadata);
+    if (ok) {
+        headers = metadata.value("headers").toStringList();
+        fieldNames = metadata.value("fieldNames").toStringList();
+        jsonFieldsDiscovered = false;
+        verticalHeaders = metadata.value("verticalHeaders").toStringList();
+        if (!headers.isEmpty()) {
+            resetHeaders();
         }
-        csv += "\n";
     }
+    tableModel->endBatch();
 
-    // Generate CSV data rows
-    for (int row = 0; row < rowCount; ++row) {
-        for (int col = 0; col < columnCount; ++col) {
-            if (col > 0) {
-                csv += ",";
-            }
-            QString value = model()->data(model()->index(row, col)).toString();
-            // Quote the value if it contains a comma
-            if (value.contains(',')) {
-                value = "\"" + value + "\"";
-            }
-            csv += value;
-        }
-        csv += "\n";
+    if (ok) {
+        notifyTableChanged();
+    }
+    return ok;
+}
+
+const QString& TableWidget::lastSnapshotError() const {
+    return tableModel->snapshotError();
+}
+
+// Sets the signals and slots for double click on table. Calls handler with data for
+// the double-clicked row.
+void TableWidget::setDoubleClickHandler(
+    std::function<void(int row, int col, const QStringList& data)> handler) {
+    doubleClickHandler = std::move(handler);
+    rowDoubleClickHandler = nullptr;
+}
+
+void TableWidget::setRowDoubleClickHandler(
+    std::function<void(int row, int col, const RowRef& data)> handler) {
+    rowDoubleClickHandler = std::move(handler);
+    doubleClickHandler = nullptr;
+}
+
+void TableWidget::activateRow(const QModelIndex& index) {
+    if (!index.isValid()) {
+        return;
+    }
+    if (doubleClickHandler) {
+        doubleClickHandler(index.row(), index.column(), rowRef(index.row()).toStringList());
+    } else if (rowDoubleClickHandler) {
+        rowDoubleClickHandler(index.row(), index.column(), rowRef(index.row()));
     }
+}
+
+RowRef TableWidget::rowRef(int row) const {
+    return {tableModel, proxyModel->sourceRow(row)};
+}
 
-    return csv;
+// Generates an html table and writes it to a QString that is returned.
+QString TableWidget::generateHtmlTable() {
+    HtmlFormatter formatter;
+    return TableExporter().format(snapshot(false), formatter);
+}
+
+// Generates and returns QString containing CSV for the table data.
+QString TableWidget::generateCsvData() {
+    // Field names head the data only when set; values are quoted as RFC 4180 requires.
+    CsvFormatter formatter(useFields(), QStringLiteral("\n"));
+    return TableExporter().format(snapshot(), formatter);
 }
 
 // Generates and returns QString containing JSON for the table data.
 // The valueConverter is required if you want to convert cell data to other types from QString.
 QString TableWidget::generateJsonData(QVariant (*valueConverter)(int col,
                                                                  const QString& cellData)) {
+    if (valueConverter == nullptr) {
+        JsonFormatter formatter;
+        return TableExporter().format(snapshot(), formatter);
+    }
+
     QJsonArray rowsArray;
 
     int rowCount = model()->rowCount();
@@ -324,10 +573,8 @@ QString TableWidget::generateJsonData(QVariant (*valueConverter)(int col,
             }
 
             QVariant cellValue = model()->data(model()->index(row, col));
-            if (valueConverter) {
-                // Convert value using the user-provided callback function
-                cellValue = valueConverter(col, cellValue.toString());
-            }
+            // Convert value using the user-provided callback function
+            cellValue = valueConverter(col, cellValue.toString());
             rowObject[columnName] = QJsonValue::fromVariant(cellValue);
         }
         rowsArray.append(rowObject);
@@ -337,120 +584,161 @@ QString TableWidget::generateJsonData(QVariant (*valueConverter)(int col,
     return jsonDoc.toJson();
 }
 
-void TableWidget::showPrintPreview() {
-    // Generate the HTML table
-    QString htmlTable = generateHtmlTable();
+bool TableWidget::exportCsv(QIODevice* device) {
+    return startExport(device, std::make_shared<CsvFormatter>());
+}
 
-    QString html = "<div style=\"text-align: center; margin-bottom:16px;\">";
+bool TableWidget::exportJson(QIODevice* device, const JsonExportOptions& options) {
+    return startExport(device, std::make_shared<JsonFormatter>(options));
+}
 
-    if (!title.isEmpty()) {
-        html += "<h1 style=\"font-size: 18px; margin-bottom: 4px;\">" + title + "</h1>";
-    }
+void TableWidget::cancelExport() {
+    exportTasks->cancel();
+}
 
-    if (!logo.isEmpty()) {
-        html += QString(
-                    "<div style=\"display: inline-block;\"><img src=\"%1\" width=\"64\" "
-                    "height=\"64\" /></div>")
-                    .arg(logo.toString());
+bool TableWidget::isExporting() const {
+    return exporting;
+}
+
+TableSnapshot TableWidget::snapshot(bool preferFieldNames, bool selectedOnly) const {
+    TableSnapshot snapshot;
+    snapshot.columns = tableModel->columns();
+
+    if (selectedOnly) {
+        snapshot.rows = selectedSourceRows();
+    } else {
+        const int rows = proxyModel->rowCount();
+        snapshot.rows.reserve(rows);
+        for (int row = 0; row < rows; ++row) {
+            snapshot.rows.append(proxyModel->sourceRow(row));
+        }
     }
 
-    html += "<br/> </div>";
-    html += htmlTable;
+    if (preferFieldNames && useFields()) {
+        snapshot.names = fieldNames;
+    } else {
+        for (int col = 0; col < tableModel->columnCount(); ++col) {
+            snapshot.names.append(tableModel->headerData(col, Qt::Horizontal).toString());
+        }
+    }
+    return snapshot;
+}
 
-    // Create a QTextDocument to set the HTML content
-    QTextDocument document;
-    document.setHtml(html);
+bool TableWidget::startExport(QIODevice* device, std::shared_ptr<ExportFormatter> formatter) {
+    if (exporting || device == nullptr || !device->isWritable()) {
+        return false;
+    }
+    exporting = true;
+
+    auto data = std::make_shared<const TableSnapshot>(snapshot());
+    exportTasks->start([this, data, formatter, device](const std::atomic<bool>& cancelled) {
+        const qint64 total = data->rowCount();
+        TableExporter exporter;
+        const bool success =
+            exporter.write(*data, *formatter, device, &cancelled, [this, total](qint64 rows) {
+                QMetaObject::invokeMethod(
+                    this, [this, rows, total]() { emit exportProgress(rows, total); },
+                    Qt::QueuedConnection);
+            });
+
+        const bool wasCancelled = cancelled.load();
+        const QString error = exporter.errorString();
+        QMetaObject::invokeMethod(
+            this,
+            [this, success, wasCancelled, error]() {
+                exporting = false;
+                if (!success && wasCancelled) {
+                    emit exportCancelled();
+                } else {
+                    emit exportFinished(success, error);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+    return true;
+}
 
-    // Create a custom HTML preview widget
-    HtmlPreviewWidget previewWidget(html);
+void TableWidget::showPrintPreview() {
+    // Pages are painted from the model's columns as the preview asks for them; no HTML or
+    // QTextDocument is built.
+    TableRenderer renderer(snapshot(false), title, TableRenderer::loadImage(logo));
+    renderer.setFont(font());
 
-    // Create a QPrintPreviewDialog and set the custom preview widget
     QPrinter printer(QPrinter::HighResolution);
     QPrintPreviewDialog previewDialog(&printer);
     previewDialog.setMinimumSize(800, 600);
     previewDialog.setWindowTitle("Print Preview");
-
-    // Set the custom preview widget as the central widget of the print preview dialog
     previewDialog.setWindowFlags(previewDialog.windowFlags() & ~Qt::WindowContextHelpButtonHint);
 
-    auto* layout = new QVBoxLayout();
-    layout->addWidget(&previewWidget);
-
-    // Connect the paintRequested signal to handle the printing
     connect(&previewDialog, &QPrintPreviewDialog::paintRequested, this,
-            [&document](QPrinter* printer) { document.print(printer); });
+            [&renderer](QPrinter* printer) { renderer.print(printer); });
 
     // Show the print preview dialog
     previewDialog.exec();
 }
 
 void TableWidget::printTable(QPrinter* printer) {
-    // Create a QTextBrowser to display the HTML content
-    QTextBrowser textBrowser;
-
-    // Generate the HTML table from the QTableView
-    QString htmlTable = generateHtmlTable();
-
-    QString html = "<div style=\"text-align: center; margin-bottom:16px;\">";
-
-    if (!title.isEmpty()) {
-        html += "<h1 style=\"font-size: 18px; margin-bottom: 4px;\">" + title + "</h1>";
-    }
-
-    if (!logo.isEmpty()) {
-        html += QString(
-                    "<div style=\"display: inline-block;\"><img src=\"%1\" width=\"64\" "
-                    "height=\"64\" /></div>")
-                    .arg(logo.toString());
-    }
-
-    html += "<br/> </div>";
-    html += htmlTable;
-
-    // Set the HTML content to the QTextBrowser
-    textBrowser.setHtml(html);
-
+    std::unique_ptr<QPrinter> ownPrinter;
     if (printer == nullptr) {
-        printer = new QPrinter(QPrinter::HighResolution);
+        ownPrinter = std::make_unique<QPrinter>(QPrinter::HighResolution);
+        printer = ownPrinter.get();
     }
 
-    // Print the QTextBrowser content
     QPrintDialog printDialog(printer);
     if (printDialog.exec() == QDialog::Accepted) {
-        textBrowser.print(printer);
+        TableRenderer renderer(snapshot(false), title, TableRenderer::loadImage(logo));
+        renderer.setFont(font());
+        renderer.print(printer);
     }
 }
 
+bool TableWidget::exportPdf(const QString& fileName) {
+    TableRenderer renderer(snapshot(false), title, TableRenderer::loadImage(logo));
+    renderer.setFont(font());
+    return renderer.writePdf(fileName);
+}
+
 void TableWidget::appendRow(const QStringList& rowData) {
-    int row = tableModel->rowCount();
-    tableModel->setRowCount(row + 1);
-    setRowData(row, rowData);
+    tableModel->appendRows({rowData});
+    notifyTableChanged();
 }
 
 void TableWidget::deleteRow(int row) {
-    if (row >= 0 && row < tableModel->rowCount()) {
-        tableModel->removeRow(row);
-        emit tableChanged();
+    // Sorting and filtering can show any model row at row.
+    const int sourceRow = row >= 0 && row < rowCount() ? proxyModel->sourceRow(row) : -1;
+    if (sourceRow >= 0) {
+        tableModel->removeRow(sourceRow);
+        notifyTableChanged();
     }
 }
 
 void TableWidget::clearTable() {
     tableModel->clear();
-    emit tableChanged();
+    notifyTableChanged();
 }
 
 void TableWidget::appendRows(const QVector<QStringList>& rowsData) {
-    int currentRowCount = tableModel->rowCount();
-    int rowsToAdd = (int)rowsData.size();
-    int newRowCount = currentRowCount + rowsToAdd;
+    // One rowsInserted notification for the whole block
+    tableModel->appendRows(rowsData);
+    notifyTableChanged();
+}
 
-    tableModel->setRowCount(newRowCount);
+void TableWidget::beginBatch() {
+    if (batchDepth++ == 0) {
+        batchChanged = false;
+    }
+    tableModel->beginBatch();
+}
 
-    for (int row = 0; row < rowsToAdd; ++row) {
-        const QStringList& rowData = rowsData[row];
-        setRowData(currentRowCount + row, rowData);
+void TableWidget::endBatch() {
+    if (batchDepth == 0) {
+        return;
+    }
+
+    tableModel->endBatch();
+    if (--batchDepth == 0 && batchChanged) {
+        emit tableChanged();
     }
-    emit tableChanged();
 }
 
 auto TableWidget::getAllTableData() const {
@@ -472,37 +760,62 @@ auto TableWidget::getAllTableData() const {
 }
 
 QList<QList<QString>> TableWidget::getSelectedRows() const {
-    QList<QList<QString>> selectedRowsData;
+    const TableSnapshot selection = snapshot(true, true);
+    const int columns = selection.columnCount();
+
+    QList<QList<QString>> rowsData(selection.rowCount());
+    QList<QString>* rows = rowsData.data();  // Detached once, before the workers write
+    parallel::forChunks(selection.rowCount(), 1024, [&](qsizetype begin, qsizetype end) {
+        QString buffer;
+        for (qsizetype index = begin; index < end; ++index) {
+            QList<QString>& cells = rows[index];
+            cells.reserve(columns);
+            for (int column = 0; column < columns; ++column) {
+                cells.append(selection.cell(int(index), column, buffer).toString());
+            }
+        }
+    });
+    return rowsData;
+}
 
-    QModelIndexList selectedIndexes = selectionModel()->selectedRows();
-    for (const QModelIndex& index : selectedIndexes) {
-        QList<QString> rowData;
+QList<int> TableWidget::selectedSourceRows() const {
+    // View rows spanned by each range, in view order so overlaps can be skipped.
+    const QItemSelection selection = selectionModel()->selection();
+    QList<QPair<int, int>> spans;
+    spans.reserve(selection.size());
+    for (const QItemSelectionRange& range : selection) {
+        if (range.isValid()) {
+            spans.append({range.top(), range.bottom()});
+        }
+    }
+    std::sort(spans.begin(), spans.end());
 
-        for (int col = 0; col < tableModel->columnCount(); ++col) {
-            QModelIndex dataIndex = tableModel->index(index.row(), col);
-            QString data = tableModel->data(dataIndex).toString();
-            rowData.append(data);
+    QList<int> rows;
+    int next = 0;  // First view row not taken yet
+    for (const auto& [top, bottom] : spans) {
+        for (int row = qMax(top, next); row <= bottom; ++row) {
+            rows.append(proxyModel->sourceRow(row));
         }
-        selectedRowsData.append(rowData);
+        next = qMax(next, bottom + 1);
     }
+    return rows;
+}
 
-    return selectedRowsData;
+TableSnapshot TableWidget::selectionSnapshot() const {
+    return snapshot(true, true);
 }
 
 std::optional<QStringList> TableWidget::getCurrentRow() const {
-    std::optional<QStringList> rowData;
-
-    QModelIndex index = currentIndex();
-    if (index.isValid()) {
-        rowData.emplace();
-
-        for (int col = 0; col < tableModel->columnCount(); ++col) {
-            QModelIndex dataIndex = tableModel->index(index.row(), col);
-            QVariant data = tableModel->data(dataIndex);
-            rowData->append(data.toString());
-        }
+    const RowRef row = currentRowRef();
+    if (!row.isValid()) {
+        return std::nullopt;
     }
-    return rowData;
+    return row.toStringList();
+}
+
+RowRef TableWidget::currentRowRef() const {
+    const QModelIndex index = currentIndex();
+    return index.isValid() ? rowRef(index.row()) : RowRef();
 }
 
 void TableWidget::selectRowRange(int startRow, int endRow) {
@@ -535,32 +848,13 @@ void TableWidget::keyPressEvent(QKeyEvent* event) {
     }
 
     if (event->key() == Qt::Key_Enter || event->key() == Qt::Key_Return) {
-        auto selected = getCurrentRow();
-        if (doubleClickHandler && selected) {
-            QModelIndex index = currentIndex();
-            doubleClickHandler(index.row(), index.column(), selected.value());
-        }
+        activateRow(currentIndex());
     }
     QTableView::keyPressEvent(event);
 }
 
 void TableWidget::mouseDoubleClickEvent(QMouseEvent* event) {
-    if (doubleClickHandler) {
-        QModelIndex index = indexAt(event->pos());
-        if (index.isValid()) {
-            int row = index.row();
-            int column = index.column();
-
-            QStringList rowData;
-            for (int c = 0; c < tableModel->columnCount(); ++c) {
-                auto* cellItem = tableModel->item(row, c);
-                if (cellItem) {
-                    rowData.append(cellItem->text());
-                }
-            }
-            doubleClickHandler(row, column, rowData);
-        }
-    }
+    activateRow(indexAt(event->pos()));
     // Call base class implementation
     QTableView::mouseDoubleClickEvent(event);
 }
@@ -612,10 +906,11 @@ void TableWidget::contextMenuEvent(QContextMenuEvent* event) {
 
 void TableWidget::filterTable(const QString& query,
                               const QRegularExpression::PatternOption caseSensitivity, int column) {
+    // This query supersedes one still waiting out its debounce.
+    filterTimer->stop();
 
     if (query.isEmpty()) {
-        proxyModel->setFilterRegularExpression(QRegularExpression());
-        proxyModel->invalidate();
+        proxyModel->clearRowFilter();
         return;
     }
 
@@ -625,7 +920,36 @@ void TableWidget::filterTable(const QString& query,
     }
 
     QRegularExpression regex(query, caseSensitivity);
-    proxyModel->setFilterRegularExpression(regex);
+    proxyModel->setRowFilter(
+        std::make_shared<RowMatcher>(regex, proxyModel->filterKeyColumn()));
+}
+
+void TableWidget::filterTableAsync(const QString& query,
+                                   QRegularExpression::PatternOption caseSensitivity,
+                                   int column) {
+    // Any scan still running is for an outdated query.
+    proxyModel->cancelRowFilterAsync();
+
+    pendingFilterQuery = query;
+    pendingFilterOptions = caseSensitivity;
+    pendingFilterColumn = column;
+    filterTimer->start(filterDebounceMs);
+}
+
+void TableWidget::applyPendingFilter() {
+    if (pendingFilterQuery.isEmpty()) {
+        proxyModel->clearRowFilter();
+        return;
+    }
+
+    // -1 is all columns
+    if (pendingFilterColumn >= -1 && pendingFilterColumn < model()->columnCount()) {
+        proxyModel->setFilterKeyColumn(pendingFilterColumn);
+    }
+
+    QRegularExpression regex(pendingFilterQuery, pendingFilterOptions);
+    proxyModel->setRowFilterAsync(
+        std::make_shared<RowMatcher>(regex, proxyModel->filterKeyColumn()));
 }
 
 void TableWidget::handleSelectionChanged(const QItemSelection& selected,
@@ -635,17 +959,14 @@ void TableWidget::handleSelectionChanged(const QItemSelection& selected,
         return;
     }
 
-    int selectedRow = selected.indexes().first().row();
-    int selectedCol = selected.indexes().first().column();
+    // The first range's corner, without expanding the selection into indexes.
+    const QModelIndex first = selected.first().topLeft();
+    const RowRef rowData = rowRef(first.row());
 
-    QStringList rowData;
-    for (int column = 0; column < tableModel->columnCount(); ++column) {
-        auto* item = tableModel->item(selectedRow, column);
-        if (item) {
-            rowData.append(item->text());
-        }
+    if (isSignalConnected(QMetaMethod::fromSignal(&TableWidget::tableSelectionChanged))) {
+        emit tableSelectionChanged(first.row(), first.column(), rowData.toStringList());
     }
-    emit tableSelectionChanged(selectedRow, selectedCol, rowData);
+    emit rowSelected(first.row(), first.column(), rowData);
 }
 
 void TableWidget::handleDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
@@ -653,7 +974,7 @@ void TableWidget::handleDataChanged(const QModelIndex& topLeft, const QModelInde
     Q_UNUSED(roles);
 
     // If no row selected, we are just setting the data
-    if (selectionModel()->selectedIndexes().isEmpty()) {
+    if (!selectionModel()->hasSelection()) {
         return;
     }
 
@@ -662,35 +983,104 @@ void TableWidget::handleDataChanged(const QModelIndex& topLeft, const QModelInde
         return;
     }
 
-    QStringList rowData;
+    // Queued, so the row may have gone since.
     const int row = topLeft.row();
+    const RowRef rowData = rowRef(row);
+    if (rowData.isValid()) {
+        if (isSignalConnected(QMetaMethod::fromSignal(&TableWidget::rowUpdated))) {
+            emit rowUpdated(row, topLeft.column(), rowData.toStringList());
+        }
+        emit rowEdited(row, topLeft.column(), rowData);
+    }
+    QTableView::dataChanged(topLeft, bottomRight, roles);
+}
+
+void TableWidget::startFeed(int capacity, int maxLatencyMs, int batchSize) {
+    stopFeed();
 
-    for (int column = 0; column < tableModel->columnCount(); ++column) {
-        QModelIndex index = tableModel->index(row, column);
-        QVariant data = tableModel->data(index);
-        QString cellData = data.toString();
-        rowData.append(cellData);
+    feedBatchSize = qMax(1, batchSize);
+    feedRejected = 0;
+    feedDrainScheduled = false;
+    feedQueue = std::make_unique<BoundedQueue<QStringList>>(qMax(capacity, feedBatchSize));
+
+    if (feedTimer == nullptr) {
+        feedTimer = new QTimer(this);
+        connect(feedTimer, &QTimer::timeout, this, &TableWidget::drainFeed);
     }
+    feedTimer->start(qMax(1, maxLatencyMs));
+}
 
-    emit rowUpdated(row, topLeft.column(), rowData);
-    QTableView::dataChanged(topLeft, bottomRight, roles);
+void TableWidget::stopFeed() {
+    if (!feedQueue) {
+        return;
+    }
+
+    feedTimer->stop();
+    while (feedQueue->sizeApprox() > 0) {
+        drainFeed();
+    }
+    feedQueue.reset();
 }
 
-void TableWidget::setRowData(int row, const QStringList& rowData) {
-    for (int column = 0; column < tableModel->columnCount(); ++column) {
-        auto* item = new QStandardItem();
-        QString text = rowData.value(column);
+bool TableWidget::pushRow(QStringList row) {
+    if (!feedQueue) {
+        return false;
+    }
 
-        // I hate nulls in a table
-        if (text == "null" || text == "undefined") {
-            text = "";
-        }
+    if (!feedQueue->tryPush(std::move(row))) {
+        feedRejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Don't wait for the timer once a full batch is waiting. Only one drain is posted at
+    // a time, so producers touch the event queue at most once per batch.
+    if (feedQueue->sizeApprox() >= static_cast<std::size_t>(feedBatchSize) &&
+        !feedDrainScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(this, &TableWidget::drainFeed, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+int TableWidget::feedBacklog() const {
+    return feedQueue ? static_cast<int>(feedQueue->sizeApprox()) : 0;
+}
+
+void TableWidget::drainFeed() {
+    feedDrainScheduled = false;
+    if (!feedQueue) {
+        return;
+    }
+
+    QVector<QStringList> batch;
+    batch.reserve(feedBatchSize);
+
+    QStringList row;
+    while (batch.size() < feedBatchSize && feedQueue->tryPop(row)) {
+        batch.append(std::move(row));
+    }
 
-        // Set the cell text
-        item->setText(text);
-        tableModel->setItem(row, column, item);
+    if (!batch.isEmpty()) {
+        appendRows(batch);
     }
 
+    const std::size_t backlog = feedQueue->sizeApprox();
+    const qint64 rejected = feedRejected.exchange(0, std::memory_order_relaxed);
+    if (rejected > 0 || backlog > feedQueue->capacity() / 4 * 3) {
+        emit feedBackpressure(static_cast<int>(backlog), rejected);
+    }
+
+    // More than a batch is waiting; keep going on the next event loop turn.
+    if (backlog >= static_cast<std::size_t>(feedBatchSize) &&
+        !feedDrainScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(this, &TableWidget::drainFeed, Qt::QueuedConnection);
+    }
+}
+
+void TableWidget::notifyTableChanged() {
+    if (batchDepth > 0) {
+        batchChanged = true;
+        return;
+    }
     emit tableChanged();
 }
 
@@ -0,0 +1,162 @@
+#include "../include/TrigramIndex.hpp"
+
+#include <QMap>
+#include <QMutex>
+#include <algorithm>
+
+#include "Parallel.hpp"
+
+template <typename Fn>
+void TrigramIndex::forEachTrigram(QStringView text, const Fn& fn) {
+    if (text.size() < 3) {
+        return;
+    }
+
+    auto fold = [](QChar c) -> quint64 {
+        const char16_t u = c.unicode();
+        if (u < 128) {
+            return (u >= 'A' && u <= 'Z') ? u + ('a' - 'A') : u;
+        }
+        return c.toCaseFolded().unicode();
+    };
+
+    quint64 key = (fold(text[0]) << 16) | fold(text[1]);
+    for (qsizetype i = 2; i < text.size(); ++i) {
+        key = ((key << 16) | fold(text[i])) & 0xFFFFFFFFFFFFULL;
+        fn(key);
+    }
+}
+
+void TrigramIndex::addRow(const QList<TableColumn>& columns, int row) {
+    auto add = [this, row](quint64 key) {
+        QList<int>& rows = m_postings[key];
+        if (rows.isEmpty() || rows.last() < row) {
+            rows.append(row);
+        } else if (rows.last() != row) {
+            // Only edits of earlier rows land here
+            auto it = std::lower_bound(rows.begin(), rows.end(), row);
+            if (*it != row) {
+                rows.insert(it, row);
+            }
+        }
+    };
+
+    QString buffer;
+    if (m_column >= 0) {
+        if (m_column < columns.size()) {
+            forEachTrigram(columns[m_column].text(row, buffer), add);
+        }
+        return;
+    }
+
+    for (const TableColumn& column : columns) {
+        forEachTrigram(column.text(row, buffer), add);
+    }
+}
+
+TrigramIndex TrigramIndex::build(const QList<TableColumn>& columns, int rowCount, int column,
+                                 const std::atomic<bool>* cancelled) {
+    // Each chunk indexes its own row range; ranges are merged in row order afterwards so
+    // every posting list comes out sorted without a sort.
+    QMutex mutex;
+    QMap<qsizetype, TrigramIndex> parts;
+    std::atomic<bool> aborted{false};
+
+    parallel::forChunks(rowCount, 16384, [&](qsizetype begin, qsizetype end) {
+        TrigramIndex part;
+        part.m_column = column;
+        for (qsizetype row = begin; row < end; ++row) {
+            if ((row & 1023) == 0 && cancelled != nullptr && cancelled->load()) {
+                aborted = true;
+                return;
+            }
+            part.addRow(columns, int(row));
+        }
+
+        QMutexLocker lock(&mutex);
+        parts.insert(begin, std::move(part));
+    });
+
+    TrigramIndex index;
+    index.m_column = column;
+    if (aborted) {
+        return index;
+    }
+
+    for (auto part = parts.cbegin(); part != parts.cend(); ++part) {
+        for (auto it = part->m_postings.cbegin(); it != part->m_postings.cend(); ++it) {
+            index.m_postings[it.key()].append(it.value());
+        }
+    }
+    index.m_rowCount = rowCount;
+    return index;
+}
+
+void TrigramIndex::appendRows(const QList<TableColumn>& columns, int first, int count) {
+    for (int row = first; row < first + count; ++row) {
+        addRow(columns, row);
+    }
+    m_rowCount = qMax(m_rowCount, first + count);
+}
+
+void TrigramIndex::updateRow(const QList<TableColumn>& columns, int row) {
+    addRow(columns, row);
+}
+
+void TrigramIndex::removeRows(int first, int count) {
+    const int end = first + count;
+    for (auto it = m_postings.begin(); it != m_postings.end();) {
+        QList<int>& rows = it.value();
+        // Posting lists are sorted, so the removed rows are one run and the rest shift down.
+        const auto from = std::lower_bound(rows.begin(), rows.end(), first);
+        const auto to = std::lower_bound(from, rows.end(), end);
+        std::for_each(to, rows.end(), [count](int& row) { row -= count; });
+        rows.erase(from, to);
+
+        if (rows.isEmpty()) {
+            it = m_postings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_rowCount -= qMax(0, qMin(end, m_rowCount) - first);
+}
+
+std::optional<QList<int>> TrigramIndex::candidates(const QStringList& literals) const {
+    QList<const QList<int>*> lists;
+    bool usable = false;
+    bool missing = false;
+
+    for (const QString& literal : literals) {
+        forEachTrigram(literal, [&](quint64 key) {
+            usable = true;
+            auto it = m_postings.constFind(key);
+            if (it == m_postings.cend()) {
+                missing = true;
+            } else {
+                lists.append(&it.value());
+            }
+        });
+    }
+
+    if (!usable) {
+        return std::nullopt;
+    }
+    if (missing) {
+        return QList<int>();
+    }
+
+    // Intersect starting from the shortest list so the working set only shrinks.
+    std::sort(lists.begin(), lists.end(),
+              [](const QList<int>* a, const QList<int>* b) { return a->size() < b->size(); });
+
+    QList<int> result = *lists.first();
+    QList<int> next;
+    for (qsizetype i = 1; i < lists.size() && !result.isEmpty(); ++i) {
+        next.clear();
+        std::set_intersection(result.cbegin(), result.cend(), lists[i]->cbegin(),
+                              lists[i]->cend(), std::back_inserter(next));
+        result.swap(next);
+    }
+    return result;
+}